@@ -32,7 +32,9 @@
 #include "vcml/logging/inscight.h"
 
 #include "vcml/tracing/tracer.h"
+#include "vcml/tracing/trace_filter.h"
 #include "vcml/tracing/tracer_file.h"
+#include "vcml/tracing/tracer_binary.h"
 #include "vcml/tracing/tracer_term.h"
 #include "vcml/tracing/tracer_inscight.h"
 
@@ -145,6 +147,7 @@
 #include "vcml/models/virtio/input.h"
 
 #include "vcml/models/meta/loader.h"
+#include "vcml/models/meta/quantum.h"
 #include "vcml/models/meta/simdev.h"
 #include "vcml/models/meta/throttle.h"
 
@@ -34,6 +34,7 @@ private:
     sc_event m_clkrst_ev;
 
     bool cmd_reset(const vector<string>& args, ostream& os);
+    bool cmd_profile(const vector<string>& args, ostream& os);
 
     void do_reset();
 
@@ -68,7 +69,11 @@ public:
 
     virtual void handle_clock_update(hz_t oldclk, hz_t newclk);
 
+    void report_profile(ostream& os);
+
 protected:
+    virtual void end_of_simulation() override;
+
     virtual void clk_notify(const clk_target_socket& socket,
                             const clk_payload& tx) override;
 
@@ -17,6 +17,7 @@
 
 #include "vcml/logging/logger.h"
 #include "vcml/tracing/tracer.h"
+#include "vcml/tracing/trace_filter.h"
 #include "vcml/properties/property.h"
 
 namespace vcml {
@@ -25,6 +26,7 @@ class module : public sc_module, public hierarchy_element
 {
 private:
     std::map<string, command_base*> m_commands;
+    trace_filter m_filter;
 
     bool cmd_clist(const vector<string>& args, ostream& os);
     bool cmd_cinfo(const vector<string>& args, ostream& os);
@@ -34,8 +36,11 @@ private:
 public:
     property<bool> trace_all;
     property<bool> trace_errors;
+    property<string> trace_rules;
     property<log_level> loglvl;
 
+    trace_filter& get_trace_filter() { return m_filter; }
+
     logger log;
 
     module() = delete;
@@ -119,8 +124,10 @@ inline command_base* module::get_command(const string& name) {
 template <typename PAYLOAD>
 void module::record(trace_direction dir, const sc_object& port,
                     const PAYLOAD& tx, const sc_time& t) const {
-    if (trace_all || (trace_errors && is_backward_trace(dir) && failed(tx)))
-        tracer::record(dir, port, tx, t);
+    if (trace_all || (trace_errors && is_backward_trace(dir) && failed(tx))) {
+        if (m_filter.accept(dir, tx, t))
+            tracer::record(dir, port, tx, t);
+    }
 }
 
 template <typename PAYLOAD>
@@ -78,6 +78,7 @@ public:
 
     property<bool> async;
     property<unsigned int> async_rate;
+    property<bool> async_parallel;
 
     property<bool> trace_callstack;
 
@@ -19,6 +19,7 @@
 
 #include "vcml/tracing/tracer.h"
 #include "vcml/tracing/tracer_file.h"
+#include "vcml/tracing/tracer_binary.h"
 #include "vcml/tracing/tracer_term.h"
 #include "vcml/tracing/tracer_inscight.h"
 
@@ -42,6 +43,7 @@ private:
     mwr::option<bool> m_trace_stdout;
     mwr::option<bool> m_trace_inscight;
     mwr::option<string> m_trace_files;
+    mwr::option<string> m_trace_binary;
 
     mwr::option<string> m_config_files;
     mwr::option<string> m_config_options;
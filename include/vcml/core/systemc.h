@@ -382,8 +382,17 @@ private:
     function<void(async_timer&)> m_cb;
 };
 
-void sc_async(function<void(void)> job);
+// Runs job on a host worker thread. In parallel mode, the SystemC thread
+// blocks until the worker reports progress instead of spinning on delta
+// cycles, allowing the workers of multiple processes to run concurrently.
+void sc_async(function<void(void)> job, bool parallel = false);
 void sc_progress(const sc_time& delta);
+// Blocks the calling async worker until SystemC time has caught up with
+// all progress it has reported so far.
+void sc_async_barrier();
+// Blocks the calling async worker while it is ahead of SystemC time by
+// limit or more.
+void sc_async_wait(const sc_time& limit);
 void sc_sync(function<void(void)> job);
 void sc_join_async();
 
@@ -392,6 +401,11 @@ bool sc_is_async();
 sc_time async_time_stamp();
 sc_time async_time_offset();
 
+// Counts events that call for fine-grained synchronization, such as
+// interrupts or accesses to registers that synchronize on read or write.
+void notify_interaction();
+u64 interaction_count();
+
 bool is_thread(sc_process_b* proc = nullptr);
 bool is_method(sc_process_b* proc = nullptr);
 
@@ -399,6 +413,8 @@ sc_process_b* current_process();
 sc_process_b* current_thread();
 sc_process_b* current_method();
 
+size_t process_index(sc_process_b* proc);
+
 bool is_stop_requested();
 void request_stop();
 
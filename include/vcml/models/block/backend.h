@@ -16,6 +16,19 @@
 namespace vcml {
 namespace block {
 
+// One contiguous host buffer of a scatter-gather request.
+struct iobuf {
+    u8* ptr;
+    size_t size;
+};
+
+inline size_t iov_length(const vector<iobuf>& iov) {
+    size_t length = 0;
+    for (const iobuf& buf : iov)
+        length += buf.size;
+    return length;
+}
+
 class backend
 {
 protected:
@@ -42,10 +55,24 @@ public:
     virtual void write(const u8* buffer, size_t size) = 0;
     virtual void save(ostream& os) = 0;
 
+    virtual void readv(const vector<iobuf>& iov);
+    virtual void writev(const vector<iobuf>& iov);
+
     virtual void wzero(size_t size, bool may_unmap);
     virtual void discard(size_t size);
     virtual void flush();
 
+    // Positional accesses start at the given offset and leave pos() alone.
+    // By default they go through the accessors above, so callers have to
+    // serialize them with everything else. Backends that report concurrent()
+    // may run them from any thread at any time instead.
+    virtual bool concurrent() const;
+
+    virtual void preadv(size_t off, const vector<iobuf>& iov);
+    virtual void pwritev(size_t off, const vector<iobuf>& iov);
+    virtual void pwzero(size_t off, size_t size, bool may_unmap);
+    virtual void pdiscard(size_t off, size_t size);
+
     static backend* create(const string& image, bool readonly);
 };
 
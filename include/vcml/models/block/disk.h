@@ -17,41 +17,121 @@
 
 #include "vcml/properties/property.h"
 #include "vcml/models/block/backend.h"
+#include "vcml/models/block/stats.h"
 
 namespace vcml {
 namespace block {
 
+class backend_cache;
+
 class disk : public module
 {
+public:
+    enum flush_policy {
+        FLUSH_WRITEBACK,
+        FLUSH_WRITETHROUGH,
+        FLUSH_UNSAFE,
+    };
+
+    enum request_type {
+        REQ_READ,
+        REQ_WRITE,
+        REQ_WZERO,
+        REQ_DISCARD,
+        REQ_FLUSH,
+    };
+
+    // An asynchronous disk access. The submitter owns the request and must
+    // keep it alive until its completion callback has been invoked, which
+    // always happens on the SystemC thread and may release the request.
+    struct request {
+        request_type type;
+        size_t offset;
+        size_t size;
+        vector<iobuf> iov;
+        bool may_unmap;
+        bool success;
+        function<void(request&)> complete;
+    };
+
 private:
+    class stats_attribute;
+
     backend* m_backend;
+    backend_cache* m_cache;
+    flush_policy m_policy;
+    atomic<size_t> m_next_pos;
+    u64 m_host_start;
+    unique_ptr<stats_attribute> m_stats_attr;
+    ofstream m_stats_stream;
+    bool m_stats_json;
+    size_t m_stats_rows;
+
+    std::recursive_mutex m_io_mtx;
+
+    mutex m_queue_mtx;
+    condition_variable m_queue_cv;
+    condition_variable m_done_cv;
+    deque<request*> m_queue;
+    vector<request*> m_done;
+    size_t m_in_flight;
+    bool m_running;
+    vector<thread> m_workers;
+    sc_event m_done_ev;
+
+    std::unique_lock<std::recursive_mutex> lock_io();
+
+    void execute(request& req);
+    void worker(size_t id);
+    void complete(request& req);
+    void complete_requests();
+
+    void classify(size_t pos, size_t size);
+    vector<pair<string, string>> collect_stats();
+    void dump_stats();
 
     bool cmd_show_stats(const vector<string>& args, ostream& os);
     bool cmd_save_image(const vector<string>& args, ostream& os);
 
 public:
     struct stats {
-        size_t num_bytes_read;
-        size_t num_bytes_written;
-        size_t num_seek_req;
-        size_t num_read_req;
-        size_t num_write_req;
-        size_t num_flush_req;
-        size_t num_discard_req;
-        size_t num_req;
-        size_t num_seek_err;
-        size_t num_read_err;
-        size_t num_write_err;
-        size_t num_flush_err;
-        size_t num_discard_err;
-        size_t num_err;
+        counter num_bytes_read;
+        counter num_bytes_written;
+        counter num_seek_req;
+        counter num_read_req;
+        counter num_write_req;
+        counter num_flush_req;
+        counter num_discard_req;
+        counter num_req;
+        counter num_seek_err;
+        counter num_read_err;
+        counter num_write_err;
+        counter num_flush_err;
+        counter num_discard_err;
+        counter num_err;
+        counter num_seq_req;
+        counter num_rand_req;
+        counter max_queue_depth;
+        latency_histogram lat_read;
+        latency_histogram lat_write;
+        latency_histogram lat_flush;
+        latency_histogram lat_discard;
     } stats;
 
     property<string> image;
     property<string> serial;
     property<bool> readonly;
+    property<size_t> io_threads;
+    property<size_t> cache_size;
+    property<string> cache_policy;
+    property<string> stats_file;
+    property<sc_time> stats_interval;
+
+    size_t in_flight() const { return m_in_flight; }
 
     bool has_backing() const { return m_backend != nullptr; }
+    bool has_cache() const { return m_cache != nullptr; }
+    flush_policy get_flush_policy() const { return m_policy; }
 
     disk(const sc_module_name& name, const string& img = "",
          bool readonly = false);
@@ -65,9 +145,25 @@ public:
     bool seek(size_t pos);
     bool read(u8* buffer, size_t size);
     bool write(const u8* buffer, size_t size);
+    bool readv(const vector<iobuf>& iov);
+    bool writev(const vector<iobuf>& iov);
     bool wzero(size_t size, bool may_unmap = true);
     bool discard(size_t size);
     bool flush();
+
+    bool preadv(size_t off, const vector<iobuf>& iov);
+    bool pwritev(size_t off, const vector<iobuf>& iov);
+    bool pwzero(size_t off, size_t size, bool may_unmap = true);
+    bool pdiscard(size_t off, size_t size);
+
+    void submit(request& req);
+
+    // Cancels all requests that have not started yet and waits for the
+    // others to finish. All their callbacks have run once this returns,
+    // the cancelled ones without success.
+    void drain();
+
+    void write_stats(ostream& os, bool json);
 };
 
 } // namespace block
@@ -0,0 +1,94 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_BLOCK_STATS_H
+#define VCML_BLOCK_STATS_H
+
+#include "vcml/core/types.h"
+
+namespace vcml {
+namespace block {
+
+// Event counter that I/O worker threads may bump while others read it. Only
+// the totals matter, so all accesses are relaxed.
+class counter
+{
+private:
+    atomic<u64> m_value;
+
+public:
+    counter(): m_value(0) {}
+    counter(const counter&) = delete;
+
+    operator u64() const { return m_value.load(std::memory_order_relaxed); }
+
+    u64 operator++(int) {
+        return m_value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void operator+=(u64 n) { m_value.fetch_add(n, std::memory_order_relaxed); }
+
+    void update_max(u64 n) {
+        u64 max = m_value.load(std::memory_order_relaxed);
+        while (n > max && !m_value.compare_exchange_weak(max, n))
+            ;
+    }
+};
+
+// Histogram of host latencies with one bucket per power of two nanoseconds.
+// Updates are relaxed atomic increments, so other threads can read it at any
+// time without slowing down the I/O path.
+class latency_histogram
+{
+public:
+    enum : size_t { NUM_BUCKETS = 40 };
+
+private:
+    atomic<u64> m_buckets[NUM_BUCKETS];
+    atomic<u64> m_count;
+    atomic<u64> m_total;
+    atomic<u64> m_max;
+
+public:
+    latency_histogram();
+
+    u64 count() const { return m_count.load(std::memory_order_relaxed); }
+    u64 total_ns() const { return m_total.load(std::memory_order_relaxed); }
+    u64 max_ns() const { return m_max.load(std::memory_order_relaxed); }
+    u64 mean_ns() const;
+
+    u64 bucket(size_t idx) const;
+    u64 percentile_ns(double p) const;
+
+    void record(u64 ns);
+    void reset();
+
+    static u64 now_ns();
+};
+
+inline u64 latency_histogram::bucket(size_t idx) const {
+    return m_buckets[idx].load(std::memory_order_relaxed);
+}
+
+inline void latency_histogram::record(u64 ns) {
+    size_t idx = ns ? min<size_t>(fls(ns), NUM_BUCKETS - 1) : 0;
+    m_buckets[idx].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(ns, std::memory_order_relaxed);
+
+    u64 max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns))
+        ;
+}
+
+} // namespace block
+} // namespace vcml
+
+#endif
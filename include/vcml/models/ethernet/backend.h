@@ -41,6 +41,11 @@ public:
 
     virtual void send_to_host(const eth_frame& frame) = 0;
     virtual void send_to_guest(eth_frame frame);
+    void send_to_guest(vector<eth_frame>& frames);
+    void send_to_guest_at(eth_frame frame, const sc_time& t);
+
+    // invoked for every frame the bridge delivers to the guest
+    virtual void observe_to_guest(const eth_frame& frame) {}
 
     static backend* create(bridge* br, const string& type);
 };
@@ -33,8 +33,10 @@ private:
     vector<backend*> m_backends;
 
     mutable mutex m_mtx;
-    queue<eth_frame> m_rx;
+    vector<eth_frame> m_rx;
+    std::multimap<sc_time, eth_frame> m_timed;
     sc_event m_ev;
+    u64 m_late;
 
     bool cmd_create_backend(const vector<string>& args, ostream& os);
     bool cmd_destroy_backend(const vector<string>& args, ostream& os);
@@ -56,8 +58,12 @@ public:
     virtual ~bridge();
     VCML_KIND(ethernet::bridge);
 
+    u64 late_frames() const { return m_late; }
+
     void send_to_host(const eth_frame& frame);
     void send_to_guest(eth_frame frame);
+    void send_to_guest(vector<eth_frame>& frames);
+    void send_to_guest_at(eth_frame frame, const sc_time& t);
 
     void attach(backend* b);
     void detach(backend* b);
@@ -16,32 +16,79 @@
 #include "vcml/core/module.h"
 #include "vcml/core/model.h"
 
+#include "vcml/properties/property.h"
 #include "vcml/protocols/eth.h"
 
 namespace vcml {
 namespace ethernet {
 
+// Connects any number of ethernet devices. By default, every frame is
+// flooded to all ports except the one it was received on. In learning mode
+// the network behaves like a switch: it records the port behind each source
+// address and forwards unicast frames only to that port. Entries expire after
+// the aging time. Broadcast, multicast and unknown destinations still flood.
 class network : public module, public eth_host
 {
+public:
+    struct port_stats {
+        u64 rx_frames;
+        u64 rx_bytes;
+        u64 tx_frames;
+        u64 tx_bytes;
+        u64 num_flooded;
+        u64 num_filtered;
+    };
+
 protected:
+    struct fdb_entry {
+        mac_addr mac;
+        u16 vlan;
+        size_t port;
+        sc_time seen;
+    };
+
     size_t m_next_id;
+    sc_time m_last_aging;
+    unordered_map<u64, fdb_entry> m_fdb;
+    unordered_map<size_t, port_stats> m_stats;
 
     const eth_initiator_socket& peer_of(const eth_target_socket& rx) const {
         return eth_tx[eth_rx.index_of(rx)];
     }
 
+    u16 vlan_of(const eth_frame& frame) const;
+    bool expired(const fdb_entry& entry) const;
+
+    void learn(size_t port, u16 vlan, const mac_addr& mac);
+    bool lookup(u16 vlan, const mac_addr& mac, size_t& port);
+    void age();
+
+    void forward(size_t port, const eth_frame& frame);
+    void flood(size_t port, const eth_frame& frame);
+
+    bool cmd_show_fdb(const vector<string>& args, ostream& os);
+
     void eth_receive(const eth_target_socket&, const eth_frame&) override;
 
 public:
+    property<bool> learning;
+    property<bool> vlan_aware;
+    property<sc_time> aging;
+
     eth_initiator_array eth_tx;
     eth_target_array eth_rx;
 
+    size_t fdb_size() const { return m_fdb.size(); }
+    port_stats get_stats(size_t port) const;
+
     network(const sc_module_name& nm);
     virtual ~network() = default;
     VCML_KIND(ethernet::network);
 
     void bind(eth_initiator_socket& tx, eth_target_socket& rx);
 
+    void flush_fdb() { m_fdb.clear(); }
+
     template <typename DEVICE>
     void connect(DEVICE& device) {
         bind(device.eth_tx, device.eth_rx);
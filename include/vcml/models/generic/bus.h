@@ -51,6 +51,14 @@ private:
     set<mapping> m_mappings;
     mapping m_default;
 
+    vector<vector<const mapping*>> m_decoders;
+    vector<const mapping*> m_shared;
+
+    static const mapping* decode(const vector<const mapping*>& table,
+                                 const range& addr);
+
+    void update_decoders();
+
     const mapping& lookup(tlm_target_socket& src, const range& addr) const;
     void handle_bus_error(tlm_generic_payload& tx) const;
 
@@ -0,0 +1,82 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_META_QUANTUM_H
+#define VCML_META_QUANTUM_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+#include "vcml/core/module.h"
+#include "vcml/core/model.h"
+
+#include "vcml/logging/logger.h"
+#include "vcml/properties/property.h"
+
+namespace vcml {
+namespace meta {
+
+class adaptive_quantum : public module
+{
+private:
+    u64 m_interactions;
+    unsigned int m_quiet;
+
+    size_t m_num_grow;
+    size_t m_num_shrink;
+
+    sc_time m_last;
+    std::map<sc_time, sc_time> m_histogram;
+
+    void set_quantum(const sc_time& quantum);
+    void account();
+    void update();
+
+    bool cmd_show_stats(const vector<string>& args, ostream& os);
+
+public:
+    property<sc_time> min_quantum;
+    property<sc_time> max_quantum;
+    property<sc_time> update_interval;
+
+    property<u64> grow_threshold;
+    property<u64> shrink_threshold;
+    property<unsigned int> hysteresis;
+
+    property<double> grow_factor;
+    property<double> shrink_factor;
+
+    size_t num_grow() const { return m_num_grow; }
+    size_t num_shrink() const { return m_num_shrink; }
+
+    sc_time current_quantum() const;
+    const std::map<sc_time, sc_time>& histogram();
+
+    adaptive_quantum(const sc_module_name& nm);
+    virtual ~adaptive_quantum() = default;
+    VCML_KIND(adaptive_quantum);
+
+protected:
+    virtual void start_of_simulation() override;
+    virtual void end_of_simulation() override;
+};
+
+inline sc_time adaptive_quantum::current_quantum() const {
+    return tlm::tlm_global_quantum::instance().get();
+}
+
+inline const std::map<sc_time, sc_time>& adaptive_quantum::histogram() {
+    account();
+    return m_histogram;
+}
+
+} // namespace meta
+} // namespace vcml
+
+#endif
@@ -53,7 +53,8 @@ private:
         } topology;
 
         u8 writeback;
-        u8 unused0[3];
+        u8 unused0;
+        u16 num_queues;
         u32 max_discard_sectors;
         u32 max_discard_seg;
         u32 discard_sector_alignment;
@@ -63,13 +64,33 @@ private:
         u8 unused1[3];
     } m_config;
 
-    bool process_command(vq_message& msg);
-    bool process_in(virtio_blk_req& req, vq_message& msg);
-    bool process_out(virtio_blk_req& req, vq_message& msg);
-    bool process_flush(virtio_blk_req& req, vq_message& msg);
-    bool process_get_id(virtio_blk_req& req, vq_message& msg);
-    bool process_discard(virtio_blk_req& req, vq_message& msg);
-    bool process_write_zeroes(virtio_blk_req& req, vq_message& msg);
+    struct io_request {
+        u32 vqid;
+        u64 epoch;
+        u64 sector;
+        bool done;
+        vq_message msg;
+        vector<u8> bounce;
+        block::disk::request disk_req;
+    };
+
+    bool m_in_order;
+    u64 m_epoch;
+    vector<list<unique_ptr<io_request>>> m_queues;
+
+    bool map_buffers(io_request& io, bool out, size_t off, size_t len);
+    void submit(io_request& io, block::disk::request_type type, u64 sector,
+                size_t size);
+    void finish(io_request& io, u8 status);
+    bool retire(u32 vqid);
+
+    bool process_command(io_request& io);
+    bool process_in(virtio_blk_req& req, io_request& io);
+    bool process_out(virtio_blk_req& req, io_request& io);
+    bool process_flush(virtio_blk_req& req, io_request& io);
+    bool process_get_id(virtio_blk_req& req, io_request& io);
+    bool process_discard(virtio_blk_req& req, io_request& io);
+    bool process_write_zeroes(virtio_blk_req& req, io_request& io);
 
     virtual void identify(virtio_device_desc& desc) override;
     virtual bool notify(u32 vqid) override;
@@ -87,6 +108,7 @@ public:
     property<u32> max_size;
     property<u32> max_discard_sectors;
     property<u32> max_write_zeroes_sectors;
+    property<u32> num_queues;
 
     block::disk disk;
 
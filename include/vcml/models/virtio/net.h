@@ -74,7 +74,7 @@ private:
     void handle_ctrl_announce(vq_message& msg);
     void handle_ctrl_mac_addr(vq_message& msg);
 
-    bool handle_rx(vq_message& msg, eth_frame& frame);
+    bool handle_rx(vq_message& msg, const eth_frame& frame);
     bool handle_tx(vq_message& msg);
 
     void rx_thread();
@@ -16,6 +16,7 @@
 #include "vcml/core/version.h"
 
 #include "vcml/tracing/tracer.h"
+#include "vcml/tracing/trace_filter.h"
 #include "vcml/properties/property.h"
 
 #if SYSTEMC_VERSION < SYSTEMC_VERSION_2_3_2
@@ -30,22 +31,30 @@ class base_socket : public hierarchy_element
 {
 private:
     sc_object* m_port;
+    trace_filter m_filter;
 
 public:
     const address_space as;
 
     property<bool> trace_all;
     property<bool> trace_errors;
+    property<string> trace_rules;
+
+    trace_filter& get_trace_filter() { return m_filter; }
 
     base_socket() = delete;
     base_socket(sc_object* port, address_space space):
         hierarchy_element(),
         m_port(port),
+        m_filter(),
         as(space),
         trace_all(port, "trace", false),
-        trace_errors(port, "trace_errors", false) {
+        trace_errors(port, "trace_errors", false),
+        trace_rules(port, "trace_rules", "") {
         trace_all.inherit_default();
         trace_errors.inherit_default();
+        trace_rules.inherit_default();
+        m_filter.configure(trace_rules);
     }
 
     virtual ~base_socket() = default;
@@ -55,14 +64,16 @@ public:
 protected:
     template <typename PAYLOAD>
     void trace_fw(const PAYLOAD& tx, const sc_time& t = SC_ZERO_TIME) {
-        if (trace_all)
+        if (trace_all && m_filter.accept(TRACE_FW, tx, t))
             tracer::record(TRACE_FW, *m_port, tx, t);
     }
 
     template <typename PAYLOAD>
     void trace_bw(const PAYLOAD& tx, const sc_time& t = SC_ZERO_TIME) {
-        if (trace_all || (trace_errors && failed(tx)))
-            tracer::record(TRACE_BW, *m_port, tx, t);
+        if (trace_all || (trace_errors && failed(tx))) {
+            if (m_filter.accept(TRACE_BW, tx, t))
+                tracer::record(TRACE_BW, *m_port, tx, t);
+        }
     }
 };
 
@@ -153,6 +164,7 @@ private:
 public:
     property<bool> trace_all;
     property<bool> trace_errors;
+    property<string> trace_rules;
 
     socket_array(const char* nm):
         sc_object(nm),
@@ -164,9 +176,11 @@ public:
         m_ids(),
         m_peer(),
         trace_all(this, "trace", false),
-        trace_errors(this, "trace_errors", false) {
+        trace_errors(this, "trace_errors", false),
+        trace_rules(this, "trace_rules", "") {
         trace_all.inherit_default();
         trace_errors.inherit_default();
+        trace_rules.inherit_default();
     }
 
     socket_array(const char* nm, size_t max): socket_array(nm) { m_max = max; }
@@ -210,6 +224,8 @@ public:
         if constexpr (supports_tracing<SOCKET>::value) {
             socket->trace_all.set_default(trace_all);
             socket->trace_errors.set_default(trace_errors);
+            socket->trace_rules.set_default(trace_rules);
+            socket->get_trace_filter().configure(socket->trace_rules);
         }
 
         m_ids[socket] = idx;
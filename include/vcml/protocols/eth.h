@@ -68,11 +68,17 @@ struct mac_addr {
     }
 };
 
-struct eth_frame : public vector<u8> {
+// Ethernet frames keep their bytes in reference counted buffers that are
+// recycled through a global pool. Copying a frame only shares its buffer, so
+// frames can be forwarded across networks, bridges and backends without any
+// allocation or copy. Writing via mutable_data or resize first detaches the
+// frame from all other frames still sharing its buffer.
+struct eth_frame {
     enum : size_t {
         FRAME_HEADER_SIZE = 14,
         FRAME_MIN_SIZE = 64,
         FRAME_MAX_SIZE = 1522,
+        POOL_LIMIT = 1024,
     };
 
     enum : u16 {
@@ -91,18 +97,43 @@ struct eth_frame : public vector<u8> {
         IP_UDP = 0x11,
     };
 
-    eth_frame() = default;
-    eth_frame(eth_frame&&) = default;
-    eth_frame(const eth_frame&) = default;
-    eth_frame(size_t length): vector<u8>(length) {}
+    typedef vector<u8>::const_iterator const_iterator;
+
+    eth_frame(): m_buf(nullptr) {}
+    eth_frame(eth_frame&& other) noexcept;
+    eth_frame(const eth_frame& other);
+    eth_frame(size_t length);
     eth_frame(const vector<u8>& raw);
     eth_frame(vector<u8>&& frame);
     eth_frame(const u8* data, size_t len);
     eth_frame(const mac_addr& dest, const mac_addr& src,
               const vector<u8>& payload);
+    ~eth_frame() { release(m_buf); }
+
+    eth_frame& operator=(const eth_frame& other);
+    eth_frame& operator=(eth_frame&& other) noexcept;
+
+    const vector<u8>& bytes() const { return m_buf ? m_buf->bytes : NO_DATA; }
+    operator const vector<u8>&() const { return bytes(); }
+
+    size_t size() const { return bytes().size(); }
+    bool empty() const { return bytes().empty(); }
+
+    const u8* data() const { return bytes().data(); }
+    u8* mutable_data() { return writable().data(); }
+    void resize(size_t length) { writable().resize(length); }
+
+    const_iterator begin() const { return bytes().begin(); }
+    const_iterator end() const { return bytes().end(); }
+
+    u8 operator[](size_t i) const { return bytes()[i]; }
+    u8 at(size_t i) const { return bytes().at(i); }
+
+    size_t use_count() const { return m_buf ? m_buf->refs.load() : 0; }
+    bool shares(const eth_frame& other) const;
 
-    eth_frame& operator=(const eth_frame&) = default;
-    eth_frame& operator=(eth_frame&&) = default;
+    bool operator==(const eth_frame& other) const;
+    bool operator!=(const eth_frame& other) const { return !(*this == other); }
 
     template <typename T>
     T read(size_t offset) const {
@@ -115,13 +146,11 @@ struct eth_frame : public vector<u8> {
     u16 ether_type() const;
 
     size_t payload_size() const { return size() - FRAME_HEADER_SIZE; }
-    u8* payload() { return data() + FRAME_HEADER_SIZE; }
     const u8* payload() const { return data() + FRAME_HEADER_SIZE; }
-    u8& payload(size_t i) { return at(FRAME_HEADER_SIZE + i); }
     u8 payload(size_t i) const { return at(FRAME_HEADER_SIZE + i); }
 
-    mac_addr destination() const { return mac_addr(*this, 0); }
-    mac_addr source() const { return mac_addr(*this, 6); }
+    mac_addr destination() const { return mac_addr(bytes(), 0); }
+    mac_addr source() const { return mac_addr(bytes(), 6); }
 
     bool is_multicast() const { return destination().is_multicast(); }
     bool is_broadcast() const { return destination().is_broadcast(); }
@@ -136,10 +165,61 @@ struct eth_frame : public vector<u8> {
     bool is_nc() const;
     bool is_avtp() const;
 
+    static size_t pool_size();
+
     static bool print_payload;
     static size_t print_payload_columns;
+
+private:
+    struct buffer {
+        atomic<size_t> refs;
+        vector<u8> bytes;
+    };
+
+    struct pool;
+
+    buffer* m_buf;
+
+    vector<u8>& writable();
+    void pad();
+
+    static const vector<u8> NO_DATA;
+
+    static buffer* allocate();
+    static void release(buffer* buf);
 };
 
+inline eth_frame::eth_frame(eth_frame&& other) noexcept: m_buf(other.m_buf) {
+    other.m_buf = nullptr;
+}
+
+inline eth_frame::eth_frame(const eth_frame& other): m_buf(other.m_buf) {
+    if (m_buf)
+        m_buf->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline eth_frame& eth_frame::operator=(const eth_frame& other) {
+    if (other.m_buf)
+        other.m_buf->refs.fetch_add(1, std::memory_order_relaxed);
+    release(m_buf);
+    m_buf = other.m_buf;
+    return *this;
+}
+
+inline eth_frame& eth_frame::operator=(eth_frame&& other) noexcept {
+    if (this != &other) {
+        release(m_buf);
+        m_buf = other.m_buf;
+        other.m_buf = nullptr;
+    }
+
+    return *this;
+}
+
+inline bool eth_frame::shares(const eth_frame& other) const {
+    return m_buf != nullptr && m_buf == other.m_buf;
+}
+
 ostream& operator<<(ostream& os, const mac_addr& addr);
 ostream& operator<<(ostream& os, const eth_frame& frame);
 
@@ -282,7 +362,7 @@ public:
     VCML_KIND(eth_initiator_socket);
 
     void send(const vector<u8>& data);
-    void send(eth_frame& frame);
+    void send(const eth_frame& frame);
 };
 
 class eth_target_socket : public eth_base_target_socket
@@ -15,6 +15,7 @@
 #include "vcml/protocols/tlm_exmon.h"
 #include "vcml/protocols/tlm_memory.h"
 #include "vcml/protocols/tlm_dmi_cache.h"
+#include "vcml/protocols/tlm_pool.h"
 #include "vcml/protocols/tlm_adapters.h"
 #include "vcml/protocols/tlm_stubs.h"
 #include "vcml/protocols/tlm_base.h"
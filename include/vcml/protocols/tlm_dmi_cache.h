@@ -20,12 +20,25 @@ namespace vcml {
 class tlm_dmi_cache
 {
 private:
+    struct snapshot {
+        vector<tlm_dmi> entries; // sorted by start address
+        vector<u64> maxend;      // highest end address up to each entry
+    };
+
     mutable mutex m_mtx;
 
     size_t m_limit;
     vector<tlm_dmi> m_entries;
 
+    atomic<u64> m_generation;
+    atomic<const snapshot*> m_snapshot;
+    atomic<size_t> m_readers;
+    vector<const snapshot*> m_retired;
+
     void insert_locked(const tlm_dmi& dmi);
+    void publish_locked();
+
+    bool lookup_snapshot(const range& r, vcml_access rwx, tlm_dmi& dmi);
 
 public:
     size_t get_entry_limit() const { return m_limit; }
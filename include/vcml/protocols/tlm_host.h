@@ -17,6 +17,7 @@
 
 #include "vcml/properties/property.h"
 #include "vcml/protocols/tlm_sbi.h"
+#include "vcml/protocols/tlm_pool.h"
 
 namespace vcml {
 
@@ -33,9 +34,14 @@ private:
         proc_data(): time(SC_ZERO_TIME), tx(nullptr), sbi(nullptr) {}
     };
 
-    mutable std::unordered_map<sc_process_b*, proc_data> m_processes;
+    // indexed by process_index, entries never move once allocated
+    mutable vector<unique_ptr<proc_data>> m_processes;
     vector<tlm_initiator_socket*> m_initiator_sockets;
     vector<tlm_target_socket*> m_target_sockets;
+    tlm_pool m_tx_pool;
+
+    proc_data& get_proc_data(sc_process_b* proc) const;
+    proc_data& new_proc_data(size_t index) const;
 
     unsigned int do_transport(tlm_target_socket& socket,
                               tlm_generic_payload& tx, const tlm_sbi& info);
@@ -74,6 +80,10 @@ public:
     tlm_host(bool allow_dmi, unsigned int bus_width);
     virtual ~tlm_host() = default;
 
+    tlm_pool& tx_pool() { return m_tx_pool; }
+    size_t tx_pool_hits() const { return m_tx_pool.hits(); }
+    size_t tx_pool_misses() const { return m_tx_pool.misses(); }
+
     sc_time& local_time(sc_process_b* proc = current_process());
     sc_time local_time_stamp(sc_process_b* proc = current_process());
 
@@ -111,43 +121,58 @@ public:
     property<bool> allow_dmi;
 };
 
+inline tlm_host::proc_data& tlm_host::get_proc_data(sc_process_b* p) const {
+    size_t index = process_index(p);
+    if (index < m_processes.size() && m_processes[index])
+        return *m_processes[index];
+    return new_proc_data(index);
+}
+
 inline bool tlm_host::in_transaction(sc_process_b* proc) const {
-    return m_processes[proc].tx != nullptr;
+    return get_proc_data(proc).tx != nullptr;
 }
 
 inline bool tlm_host::in_debug_transaction(sc_process_b* proc) const {
-    return m_processes[proc].sbi && m_processes[proc].sbi->is_debug;
+    const proc_data& data = get_proc_data(proc);
+    return data.sbi && data.sbi->is_debug;
 }
 
 inline bool tlm_host::in_secure_transaction(sc_process_b* proc) const {
-    return m_processes[proc].sbi && m_processes[proc].sbi->is_secure;
+    const proc_data& data = get_proc_data(proc);
+    return data.sbi && data.sbi->is_secure;
 }
 
 inline int tlm_host::current_cpu(sc_process_b* proc) const {
-    return m_processes[proc].sbi ? m_processes[proc].sbi->cpuid : -1;
+    const proc_data& data = get_proc_data(proc);
+    return data.sbi ? data.sbi->cpuid : -1;
 }
 
 inline int tlm_host::current_privilege(sc_process_b* proc) const {
-    return m_processes[proc].sbi ? m_processes[proc].sbi->privilege : 0;
+    const proc_data& data = get_proc_data(proc);
+    return data.sbi ? data.sbi->privilege : 0;
 }
 
 inline const tlm_generic_payload& tlm_host::current_transaction(
     sc_process_b* proc) const {
-    VCML_ERROR_ON(!m_processes[proc].tx, "no current transaction");
-    return *m_processes[proc].tx;
+    const proc_data& data = get_proc_data(proc);
+    VCML_ERROR_ON(!data.tx, "no current transaction");
+    return *data.tx;
 }
 
 inline const tlm_sbi& tlm_host::current_sideband(sc_process_b* proc) const {
-    VCML_ERROR_ON(!m_processes[proc].sbi, "no current transaction");
-    return *m_processes[proc].sbi;
+    const proc_data& data = get_proc_data(proc);
+    VCML_ERROR_ON(!data.sbi, "no current transaction");
+    return *data.sbi;
 }
 
 inline size_t tlm_host::current_transaction_size(sc_process_b* proc) const {
-    return m_processes[proc].tx ? m_processes[proc].tx->get_data_length() : 0;
+    const proc_data& data = get_proc_data(proc);
+    return data.tx ? data.tx->get_data_length() : 0;
 }
 
 inline range tlm_host::current_transaction_address(sc_process_b* proc) const {
-    return m_processes[proc].tx ? range(*m_processes[proc].tx) : range();
+    const proc_data& data = get_proc_data(proc);
+    return data.tx ? range(*data.tx) : range();
 }
 
 inline const vector<tlm_initiator_socket*>&
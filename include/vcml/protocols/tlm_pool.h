@@ -0,0 +1,85 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_PROTOCOLS_TLM_POOL_H
+#define VCML_PROTOCOLS_TLM_POOL_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+
+#include "vcml/protocols/tlm_sbi.h"
+
+namespace vcml {
+
+// Recycles generic payloads to avoid heap allocations on transaction paths.
+// Payloads handed out by the pool carry an sbiext and are reference counted
+// via acquire/release; they return to the pool once the last reference is
+// released. Any further extensions should be attached via set_auto_extension
+// so that they get cleared before the payload is reused. The SystemC thread
+// has a free list of its own and only falls back to the locked shared one
+// when that runs empty; other threads always go through the shared list.
+class tlm_pool : public tlm::tlm_mm_interface
+{
+private:
+    mutable mutex m_mtx;
+    vector<tlm_generic_payload*> m_free;
+    vector<tlm_generic_payload*> m_local;
+    atomic<size_t> m_hits;
+    atomic<size_t> m_misses;
+
+public:
+    size_t hits() const;
+    size_t misses() const;
+    size_t size() const;
+
+    tlm_pool();
+    virtual ~tlm_pool();
+
+    tlm_pool(const tlm_pool&) = delete;
+    tlm_pool& operator=(const tlm_pool&) = delete;
+
+    tlm_generic_payload* allocate();
+    virtual void free(tlm_generic_payload* tx) override;
+};
+
+inline size_t tlm_pool::hits() const {
+    return m_hits.load(std::memory_order_relaxed);
+}
+
+inline size_t tlm_pool::misses() const {
+    return m_misses.load(std::memory_order_relaxed);
+}
+
+// only exact when called from the SystemC thread
+inline size_t tlm_pool::size() const {
+    lock_guard<mutex> guard(m_mtx);
+    return m_free.size() + m_local.size();
+}
+
+class tlm_pooled_tx
+{
+private:
+    tlm_generic_payload* m_tx;
+
+public:
+    tlm_generic_payload* get() const { return m_tx; }
+    tlm_generic_payload& operator*() const { return *m_tx; }
+    tlm_generic_payload* operator->() const { return m_tx; }
+
+    explicit tlm_pooled_tx(tlm_pool& pool): m_tx(pool.allocate()) {}
+    ~tlm_pooled_tx() { m_tx->release(); }
+
+    tlm_pooled_tx(const tlm_pooled_tx&) = delete;
+    tlm_pooled_tx& operator=(const tlm_pooled_tx&) = delete;
+};
+
+} // namespace vcml
+
+#endif
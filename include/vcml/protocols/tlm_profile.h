@@ -0,0 +1,89 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_PROTOCOLS_TLM_PROFILE_H
+#define VCML_PROTOCOLS_TLM_PROFILE_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+#include "vcml/core/range.h"
+
+namespace vcml {
+
+struct tlm_profile_counters {
+    u64 count;
+    u64 bytes;
+    u64 host_ns;
+    u64 dmi;
+    u64 debug;
+    u64 errors;
+
+    tlm_profile_counters& operator+=(const tlm_profile_counters& other);
+};
+
+// Collects transaction statistics bucketed by address range. Every host
+// thread records into its own shard, shards are only merged for reporting.
+class tlm_profile
+{
+public:
+    struct entry {
+        range addr;
+        tlm_profile_counters counters;
+    };
+
+    u64 granule() const { return m_granule; }
+
+    explicit tlm_profile(u64 granule);
+    ~tlm_profile();
+
+    tlm_profile() = delete;
+    tlm_profile(const tlm_profile&) = delete;
+
+    void record(u64 addr, unsigned int bytes, u64 host_ns, bool dmi,
+                bool debug, bool error);
+    void record(const tlm_generic_payload& tx, u64 host_ns, bool debug);
+
+    vector<entry> collect() const;
+    tlm_profile_counters total() const;
+    void reset();
+
+    void report(ostream& os) const;
+
+    static u64 host_ns();
+
+private:
+    struct shard {
+        mutex mtx;
+        unordered_map<u64, tlm_profile_counters> buckets;
+    };
+
+    const u64 m_id;
+    const u64 m_granule;
+
+    mutable mutex m_mtx;
+    vector<unique_ptr<shard>> m_shards;
+
+    shard& local_shard();
+};
+
+inline void tlm_profile::record(const tlm_generic_payload& tx, u64 host_ns,
+                                bool debug) {
+    record(tx.get_address(), tx.get_data_length(), host_ns,
+           tx.is_dmi_allowed(), debug, failed(tx));
+}
+
+inline u64 tlm_profile::host_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+} // namespace vcml
+
+#endif
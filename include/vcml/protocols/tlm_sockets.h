@@ -23,6 +23,7 @@
 #include "vcml/protocols/tlm_stubs.h"
 #include "vcml/protocols/tlm_adapters.h"
 #include "vcml/protocols/tlm_dmi_cache.h"
+#include "vcml/protocols/tlm_profile.h"
 #include "vcml/protocols/tlm_host.h"
 #include "vcml/protocols/tlm_base.h"
 
@@ -31,6 +32,12 @@
 
 namespace vcml {
 
+struct tlm_iovec {
+    u64 addr;
+    void* data;
+    unsigned int size;
+};
+
 class tlm_initiator_socket
     : public simple_initiator_socket<tlm_initiator_socket>,
       public hierarchy_element
@@ -44,10 +51,15 @@ private:
     tlm_host* m_host;
     module* m_parent;
     module* m_adapter;
+    unique_ptr<tlm_profile> m_profile;
+    trace_filter m_filter;
 
     void trace_fw(const tlm_generic_payload& tx, const sc_time& t);
     void trace_bw(const tlm_generic_payload& tx, const sc_time& t);
 
+    unsigned int do_send(tlm_generic_payload& tx, const tlm_sbi& info,
+                         bool trace);
+
     void invalidate_direct_mem_ptr_int(sc_dt::uint64 start, sc_dt::uint64 end);
 
 protected:
@@ -56,7 +68,13 @@ protected:
 public:
     property<bool> trace_all;
     property<bool> trace_errors;
+    property<string> trace_rules;
     property<bool> allow_dmi;
+    property<bool> profile;
+    property<u64> profile_granule;
+
+    tlm_profile& get_profile() { return *m_profile; }
+    trace_filter& get_trace_filter() { return m_filter; }
 
     int get_cpuid() const { return m_sbi.cpuid; }
     int get_privilege() const { return m_sbi.privilege; }
@@ -92,6 +110,16 @@ public:
                                const tlm_sbi& info = SBI_NONE,
                                unsigned int* nbytes = nullptr);
 
+    tlm_response_status access_vectored(tlm_command cmd,
+                                        const tlm_iovec* iov, size_t count,
+                                        const tlm_sbi& info = SBI_NONE,
+                                        unsigned int* nbytes = nullptr);
+
+    tlm_response_status access_vectored(tlm_command cmd,
+                                        const vector<tlm_iovec>& iov,
+                                        const tlm_sbi& info = SBI_NONE,
+                                        unsigned int* nbytes = nullptr);
+
     tlm_response_status read(u64 addr, void* data, unsigned int size,
                              const tlm_sbi& info = SBI_NONE,
                              unsigned int* nbytes = nullptr);
@@ -122,14 +150,16 @@ public:
 
 inline void tlm_initiator_socket::trace_fw(const tlm_generic_payload& tx,
                                            const sc_time& t) {
-    if (trace_all)
+    if (trace_all && m_filter.accept(TRACE_FW, tx, t))
         tracer::record(TRACE_FW, *this, tx, t);
 }
 
 inline void tlm_initiator_socket::trace_bw(const tlm_generic_payload& tx,
                                            const sc_time& t) {
-    if (trace_all || (trace_errors && failed(tx)))
-        tracer::record(TRACE_BW, *this, tx, t);
+    if (trace_all || (trace_errors && failed(tx))) {
+        if (m_filter.accept(TRACE_BW, tx, t))
+            tracer::record(TRACE_BW, *this, tx, t);
+    }
 }
 
 inline void tlm_initiator_socket::set_cpuid(u64 cpuid) {
@@ -161,6 +191,12 @@ inline void tlm_initiator_socket::unmap_dmi(u64 start, u64 end) {
         m_dmi_cache->invalidate(start, end);
 }
 
+inline tlm_response_status tlm_initiator_socket::access_vectored(
+    tlm_command cmd, const vector<tlm_iovec>& iov, const tlm_sbi& info,
+    unsigned int* nbytes) {
+    return access_vectored(cmd, iov.data(), iov.size(), info, nbytes);
+}
+
 inline tlm_response_status tlm_initiator_socket::read(u64 addr, void* data,
                                                       unsigned int size,
                                                       const tlm_sbi& info,
@@ -249,6 +285,9 @@ private:
     tlm_generic_payload* m_payload;
     tlm_sbi m_sideband;
 
+    unique_ptr<tlm_profile> m_profile;
+    trace_filter m_filter;
+
     void wait_free();
 
     void trace_fw(const tlm_generic_payload& tx, const sc_time& t);
@@ -266,10 +305,16 @@ protected:
 public:
     property<bool> trace_all;
     property<bool> trace_errors;
+    property<string> trace_rules;
     property<bool> allow_dmi;
+    property<bool> profile;
+    property<u64> profile_granule;
 
     const address_space as;
 
+    tlm_profile& get_profile() { return *m_profile; }
+    trace_filter& get_trace_filter() { return m_filter; }
+
     tlm_target_socket() = delete;
     tlm_target_socket(const char* name, address_space a = VCML_AS_DEFAULT);
     virtual ~tlm_target_socket();
@@ -318,14 +363,16 @@ inline void tlm_target_socket::wait_free() {
 
 inline void tlm_target_socket::trace_fw(const tlm_generic_payload& tx,
                                         const sc_time& t) {
-    if (trace_all)
+    if (trace_all && m_filter.accept(TRACE_FW, tx, t))
         tracer::record(TRACE_FW, *this, tx, t);
 }
 
 inline void tlm_target_socket::trace_bw(const tlm_generic_payload& tx,
                                         const sc_time& t) {
-    if (trace_all || (trace_errors && failed(tx)))
-        tracer::record(TRACE_BW, *this, tx, t);
+    if (trace_all || (trace_errors && failed(tx))) {
+        if (m_filter.accept(TRACE_BW, tx, t))
+            tracer::record(TRACE_BW, *this, tx, t);
+    }
 }
 
 inline tlm_dmi_cache& tlm_target_socket::dmi_cache() {
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_TRACE_FILTER_H
+#define VCML_TRACE_FILTER_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+#include "vcml/core/range.h"
+
+#include "vcml/tracing/tracer.h"
+
+namespace vcml {
+
+// Decides whether an activity on a port gets handed to the tracers. Filters
+// are parsed once from a specification string, e.g.
+//   "proto:tlm addr:0x1000..0x1fff cmd:write errors sample:10 time:1ms..2ms"
+// An empty specification accepts everything and costs a single branch.
+class trace_filter
+{
+private:
+    bool m_active;
+    bool m_errors;
+    bool m_windowed;
+    u32 m_protocols;
+    u32 m_commands;
+    u64 m_sample;
+    sc_time m_start;
+    sc_time m_stop;
+    vector<range> m_addresses;
+
+    mutable u64 m_counter;
+    mutable bool m_sampled;
+
+    bool accept_tlm(const tlm_generic_payload& tx) const;
+    bool accept_sample(trace_direction dir) const;
+
+public:
+    bool is_active() const { return m_active; }
+
+    trace_filter();
+    explicit trace_filter(const string& spec);
+
+    void configure(const string& spec);
+    void clear();
+
+    template <typename PAYLOAD>
+    bool accept(trace_direction dir, const PAYLOAD& tx,
+                const sc_time& t = SC_ZERO_TIME) const;
+};
+
+template <typename PAYLOAD>
+inline bool trace_filter::accept(trace_direction dir, const PAYLOAD& tx,
+                                 const sc_time& t) const {
+    if (!m_active)
+        return true;
+
+    if (!(m_protocols & (1u << protocol<PAYLOAD>::KIND)))
+        return false;
+
+    if (m_errors && !(is_backward_trace(dir) && failed(tx)))
+        return false;
+
+    if constexpr (std::is_same_v<PAYLOAD, tlm_generic_payload>) {
+        if (!accept_tlm(tx))
+            return false;
+    }
+
+    if (m_windowed) {
+        sc_time now = t + sc_time_stamp();
+        if (now < m_start || now >= m_stop)
+            return false;
+    }
+
+    return m_sample < 2 || accept_sample(dir);
+}
+
+} // namespace vcml
+
+#endif
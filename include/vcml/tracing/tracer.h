@@ -160,6 +160,7 @@ class tracer
 {
 private:
     mutable mutex m_mtx;
+    bool m_serialize;
 
 public:
     template <typename PAYLOAD>
@@ -208,11 +209,17 @@ public:
     virtual void trace(const activity<can_frame>&) = 0;
     virtual void trace(const activity<usb_packet>&) = 0;
 
+    bool is_serialized() const { return m_serialize; }
+
     tracer();
+    explicit tracer(bool serialize);
     virtual ~tracer();
 
     template <typename PAYLOAD>
     void do_trace(const activity<PAYLOAD>& msg) {
+        if (!m_serialize)
+            return trace(msg);
+
         lock_guard<mutex> guard(m_mtx);
         trace(msg);
     }
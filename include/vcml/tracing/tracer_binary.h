@@ -0,0 +1,113 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_TRACER_BINARY_H
+#define VCML_TRACER_BINARY_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+
+#include "vcml/tracing/tracer.h"
+
+namespace vcml {
+
+// Records activities into fixed-layout binary records that are collected in
+// per-thread rings without taking any locks. A background thread drains the
+// rings, compresses the collected data in blocks and writes them to a file.
+// Use tracer_binary::convert (or vcml-traceconv) to produce the same text
+// output that tracer_file would have written. If writing the file fails,
+// for example because the disk is full, the error is logged once and all
+// further records are dropped and counted instead.
+class tracer_binary : public tracer
+{
+public:
+    enum : size_t {
+        RING_SIZE = 4 * MiB,
+        MAX_RECORD = RING_SIZE / 4,
+        BLOCK_SIZE = 1 * MiB,
+    };
+
+private:
+    class ring;
+
+    const u64 m_id;
+
+    string m_filename;
+    ofstream m_stream;
+    u64 m_offset;
+
+    mutable mutex m_rings_mtx;
+    vector<unique_ptr<ring>> m_rings;
+
+    mutable mutex m_ports_mtx;
+    unordered_map<string, u32> m_ports;
+    vector<pair<u32, string>> m_names;
+
+    mutex m_write_mtx;
+    vector<u8> m_block;
+    vector<u8> m_packed;
+    vector<u8> m_index;
+    atomic<u64> m_records;
+    atomic<u64> m_dropped;
+    atomic<u64> m_bytes;
+    atomic<bool> m_failed;
+
+    mutex m_wake_mtx;
+    condition_variable m_wake;
+    atomic<bool> m_kicked;
+    atomic<bool> m_running;
+    thread m_writer;
+
+    ring& local_ring();
+    u32 port_id(ring& r, const sc_object& port);
+
+    template <typename PAYLOAD>
+    void store(const activity<PAYLOAD>& msg);
+
+    void kick();
+    void writer();
+    void fail();
+    bool write_block(u32 type, const vector<u8>& data, u64 count,
+                     u64 first = 0, u64 last = 0);
+    void write_names();
+    void write_data();
+
+public:
+    const char* filename() const { return m_filename.c_str(); }
+
+    u64 records() const { return m_records; }
+    u64 dropped() const { return m_dropped; }
+    u64 bytes_written() const { return m_bytes; }
+
+    virtual void trace(const activity<tlm_generic_payload>&) override;
+    virtual void trace(const activity<gpio_payload>&) override;
+    virtual void trace(const activity<clk_payload>&) override;
+    virtual void trace(const activity<pci_payload>&) override;
+    virtual void trace(const activity<i2c_payload>&) override;
+    virtual void trace(const activity<spi_payload>&) override;
+    virtual void trace(const activity<sd_command>&) override;
+    virtual void trace(const activity<sd_data>&) override;
+    virtual void trace(const activity<vq_message>&) override;
+    virtual void trace(const activity<serial_payload>&) override;
+    virtual void trace(const activity<eth_frame>&) override;
+    virtual void trace(const activity<can_frame>&) override;
+    virtual void trace(const activity<usb_packet>&) override;
+
+    tracer_binary(const string& filename);
+    virtual ~tracer_binary();
+
+    void flush();
+
+    static void convert(const string& filename, ostream& os);
+};
+
+} // namespace vcml
+
+#endif
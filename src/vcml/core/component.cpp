@@ -18,6 +18,20 @@ bool component::cmd_reset(const vector<string>& args, ostream& os) {
     return true;
 }
 
+bool component::cmd_profile(const vector<string>& args, ostream& os) {
+    if (!args.empty() && args[0] == "reset") {
+        for (auto* socket : get_tlm_initiator_sockets())
+            socket->get_profile().reset();
+        for (auto* socket : get_tlm_target_sockets())
+            socket->get_profile().reset();
+        os << "OK";
+        return true;
+    }
+
+    report_profile(os);
+    return true;
+}
+
 void component::do_reset() {
     for (auto socket : get_tlm_target_sockets())
         socket->invalidate_dmi();
@@ -35,6 +49,9 @@ component::component(const sc_module_name& nm, bool dmi, unsigned int bus):
     rst("rst") {
     register_command("reset", 0, &component::cmd_reset,
                      "resets this component");
+    register_command("profile", 0, &component::cmd_profile,
+                     "reports transaction profiles of all sockets, use "
+                     "'profile reset' to clear them");
 }
 
 component::~component() {
@@ -45,6 +62,44 @@ void component::reset() {
     // to be overloaded
 }
 
+void component::report_profile(ostream& os) {
+    bool first = true;
+    auto report = [&](const char* name, const tlm_profile& profile) {
+        if (!first)
+            os << std::endl;
+        os << name << ": ";
+        profile.report(os);
+        first = false;
+    };
+
+    for (auto* socket : get_tlm_initiator_sockets())
+        if (socket->profile)
+            report(socket->name(), socket->get_profile());
+    for (auto* socket : get_tlm_target_sockets())
+        if (socket->profile)
+            report(socket->name(), socket->get_profile());
+
+    if (first)
+        os << "profiling disabled for all sockets";
+}
+
+void component::end_of_simulation() {
+    auto log_profile = [&](const char* name, const tlm_profile& profile) {
+        stringstream ss;
+        profile.report(ss);
+        log_info("profile %s: %s", name, ss.str().c_str());
+    };
+
+    for (auto* socket : get_tlm_initiator_sockets())
+        if (socket->profile)
+            log_profile(socket->name(), socket->get_profile());
+    for (auto* socket : get_tlm_target_sockets())
+        if (socket->profile)
+            log_profile(socket->name(), socket->get_profile());
+
+    module::end_of_simulation();
+}
+
 void component::wait_clock_reset() {
     if (!is_thread())
         return;
@@ -48,13 +48,17 @@ module::module(const sc_module_name& nm):
     sc_module(nm),
     hierarchy_element(),
     m_commands(),
+    m_filter(),
     trace_all("trace", false),
     trace_errors("trace_errors", false),
+    trace_rules("trace_rules", ""),
     loglvl("loglvl", LOG_INFO),
     log(this) {
     trace_all.inherit_default();
     trace_errors.inherit_default();
+    trace_rules.inherit_default();
     loglvl.inherit_default();
+    m_filter.configure(trace_rules);
     register_command("clist", 0, &module::cmd_clist,
                      "returns a list of supported commands");
     register_command("cinfo", 1, &module::cmd_cinfo,
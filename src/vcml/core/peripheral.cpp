@@ -66,20 +66,33 @@ void peripheral::reset() {
             r->reset();
 }
 
+// Registers of one address space never overlap and are kept sorted by their
+// start address, so their end addresses are sorted as well. This allows
+// finding the first register that could overlap with a given address range
+// via binary search.
+static vector<reg_base*>::const_iterator find_first_register(
+    const vector<reg_base*>& regs, u64 addr) {
+    return std::lower_bound(regs.begin(), regs.end(), addr,
+                            [](const reg_base* reg, u64 a) -> bool {
+                                return reg->get_range().end < a;
+                            });
+}
+
 void peripheral::add_register(reg_base* reg) {
-    if (stl_contains(m_registers[reg->as], reg))
+    vector<reg_base*>& regs = m_registers[reg->as];
+    if (stl_contains(regs, reg))
         VCML_ERROR("register %s already assigned", reg->name());
 
-    for (auto r : m_registers[reg->as]) {
-        if (r->get_range().overlaps(reg->get_range()))
-            VCML_ERROR(
-                "address space of register %s (%d: %s) already in "
-                "use by register %s",
-                reg->name(), reg->as, to_string(reg->get_range()).c_str(),
-                r->name());
+    const range& addr = reg->get_range();
+    auto it = find_first_register(regs, addr.start);
+    if (it != regs.end() && (*it)->get_range().overlaps(addr)) {
+        VCML_ERROR(
+            "address space of register %s (%d: %s) already in "
+            "use by register %s",
+            reg->name(), reg->as, to_string(addr).c_str(), (*it)->name());
     }
 
-    mwr::stl_insert_sorted(m_registers[reg->as], reg,
+    mwr::stl_insert_sorted(regs, reg,
                            [](const reg_base* a, const reg_base* b) -> bool {
                                return a->get_address() < b->get_address();
                            });
@@ -197,16 +210,21 @@ unsigned int peripheral::receive(tlm_generic_payload& tx, const tlm_sbi& info,
 
     set_current_cpu(info.cpuid);
 
-    for (auto* reg : m_registers[as]) {
-        if (reg->get_range().overlaps(tx)) {
-            bytes += reg->receive(tx, info);
+    const vector<reg_base*>& regs = get_registers(as);
+    const range span(tx);
+    for (auto it = find_first_register(regs, span.start); it != regs.end();
+         it++) {
+        reg_base* reg = *it;
+        if (reg->get_address() > span.end)
+            break;
 
-            if (success(tx) && reg->is_natural_accesses_only())
-                break;
+        bytes += reg->receive(tx, info);
 
-            if (failed(tx))
-                break;
-        }
+        if (success(tx) && reg->is_natural_accesses_only())
+            break;
+
+        if (failed(tx))
+            break;
     }
 
     set_current_cpu(SBI_NONE.cpuid);
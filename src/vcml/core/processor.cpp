@@ -283,7 +283,8 @@ void processor::processor_thread() {
         wait_clock_reset();
 
         if (async && !is_stepping()) {
-            vcml::sc_async([&]() { running = processor_thread_async(); });
+            auto job = [&]() { running = processor_thread_async(); };
+            vcml::sc_async(job, async_parallel);
         } else {
             running = processor_thread_sync();
         }
@@ -300,8 +301,15 @@ bool processor::processor_thread_async() {
         log_warn("async_rate is larger than 10 - value: %u", async_rate.get());
 
     sc_time& lt = local_time();
-    const sc_time& quantum = tlm::tlm_global_quantum::instance().get();
 
+    // the global quantum may change on the SystemC thread at any time, so
+    // only read it from there and work with a copy until the next sync
+    sc_time quantum;
+    auto fetch_quantum = [&]() -> void {
+        quantum = tlm::tlm_global_quantum::instance().get();
+    };
+
+    sc_sync(fetch_quantum);
     sc_progress(lt);
     lt = SC_ZERO_TIME;
 
@@ -331,8 +339,14 @@ bool processor::processor_thread_async() {
             lt = SC_ZERO_TIME;
         }
 
-        while (sim_running() && async_time_offset() >= quantum)
-            mwr::cpu_yield();
+        // in parallel mode, SystemC must consume the whole quantum before
+        // we continue, otherwise we resume as soon as it is within reach
+        if (async_parallel)
+            sc_async_barrier();
+        else
+            sc_async_wait(quantum);
+
+        sc_sync(fetch_quantum);
     }
 }
 
@@ -388,6 +402,7 @@ processor::processor(const sc_module_name& nm, const string& cpuarch):
     gdb_term("gdb_term", "gdbterm"),
     async("async", false),
     async_rate("async_rate", 5),
+    async_parallel("async_parallel", false),
     trace_callstack("trace_callstack", false),
     irq("irq"),
     insn("insn"),
@@ -504,6 +519,7 @@ void processor::gpio_notify(const gpio_target_socket& socket, bool state,
     stats.irq_status = state;
 
     if (state) {
+        notify_interaction();
         stats.irq_count++;
         stats.irq_last = sc_time_stamp();
     } else {
@@ -116,10 +116,10 @@ unsigned int reg_base::receive(tlm_generic_payload& tx, const tlm_sbi& info) {
     tx.set_data_length(span.length());
 
     if (!info.is_debug) {
-        if (tx.is_read() && m_rsync)
-            m_host->sync();
-        if (tx.is_write() && m_wsync)
+        if ((tx.is_read() && m_rsync) || (tx.is_write() && m_wsync)) {
+            notify_interaction();
             m_host->sync();
+        }
     }
 
     m_host->trace_fw(*this, tx, m_host->local_time());
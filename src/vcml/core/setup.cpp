@@ -53,6 +53,7 @@ setup::setup(int argc, char** argv):
     m_trace_stdout("--trace-stdout", "Send tracing output to stdout"),
     m_trace_inscight("--trace-inscight", "Send tracing output to InSCight"),
     m_trace_files("--trace", "-t", "Send tracing output to file"),
+    m_trace_binary("--trace-binary", "Send binary tracing output to file"),
     m_config_files("--file", "-f", "Load configuration from file"),
     m_config_options("--config", "-c", "Specify individual property values"),
     m_help("--help", "-h", "Prints this message", exit_usage),
@@ -101,6 +102,11 @@ setup::setup(int argc, char** argv):
         m_tracers.push_back(t);
     }
 
+    for (const string& file : m_trace_binary.values()) {
+        tracer* t = new tracer_binary(file);
+        m_tracers.push_back(t);
+    }
+
     if (m_trace_stdout) {
         tracer* t = new tracer_term(true);
         m_tracers.push_back(t);
@@ -567,22 +567,74 @@ void async_timer::reset(const sc_time& delta) {
 
 thread_local struct async_worker* g_async = nullptr;
 
+// Lets a thread wait until a condition becomes true. Waiters spin for a
+// bounded number of iterations first, so that quick handoffs avoid a context
+// switch, and then go to sleep, so that idle waiters do not occupy a host
+// core. State changes must be published before calling ring().
+class async_doorbell
+{
+private:
+    atomic<size_t> m_sleepers;
+    mutex m_mtx;
+    condition_variable m_cv;
+
+public:
+    enum : size_t { SPIN_COUNT = 1000 };
+
+    async_doorbell(): m_sleepers(0), m_mtx(), m_cv() {}
+
+    void ring() {
+        if (m_sleepers > 0) {
+            lock_guard<mutex> guard(m_mtx);
+            m_cv.notify_all();
+        }
+    }
+
+    template <typename PREDICATE>
+    void wait(PREDICATE pred) {
+        for (size_t i = 0; i < SPIN_COUNT; i++) {
+            if (pred())
+                return;
+            mwr::cpu_yield();
+        }
+
+        std::unique_lock<mutex> lock(m_mtx);
+        m_sleepers++;
+        while (!pred()) // timeout covers conditions outside our control
+            m_cv.wait_for(lock, std::chrono::milliseconds(1));
+        m_sleepers--;
+    }
+};
+
+struct async_sync_job {
+    function<void(void)> func;
+    atomic<bool> done;
+
+    explicit async_sync_job(function<void(void)>&& fn):
+        func(std::move(fn)), done() {}
+};
+
 struct async_worker {
     const size_t id;
     sc_process_b* const process;
 
     atomic<bool> alive;
     atomic<bool> working;
+    atomic<bool> parallel;
     function<void(void)> task;
 
     atomic<u64> progress;
-    atomic<function<void(void)>*> request;
+    atomic<u64> completed;
+    u64 reported;
 
-    mutex mtx;
-    condition_variable_any notify;
-    thread worker;
+    // a worker blocks until its job is done, so one slot is enough
+    atomic<async_sync_job*> request;
+    async_doorbell worker_bell;
+    async_doorbell kernel_bell;
 
-    sc_time sc_thread_pos;
+    atomic<u64> sc_thread_pos;
+
+    thread worker;
 
     struct sim_terminated_exception {};
 
@@ -591,13 +643,16 @@ struct async_worker {
         process(worker_proc),
         alive(true),
         working(false),
+        parallel(false),
         task(),
         progress(0),
+        completed(0),
+        reported(0),
         request(nullptr),
-        mtx(),
-        notify(),
-        worker(&async_worker::work, this),
-        sc_thread_pos(sc_time_stamp()) {
+        worker_bell(),
+        kernel_bell(),
+        sc_thread_pos(sc_time_stamp().value()),
+        worker(&async_worker::work, this) {
         VCML_ERROR_ON(!process, "invalid parent process");
     }
 
@@ -607,80 +662,126 @@ struct async_worker {
         g_async = this;
         mwr::set_thread_name(mkstr("vcml_async:%zu", id));
 
-        mtx.lock();
-        while (alive) {
-            while (alive && !working)
-                notify.wait(mtx);
-
+        while (true) {
+            worker_bell.wait([&]() -> bool { return !alive || working; });
             if (!alive)
                 break;
 
             try {
-                mtx.unlock();
                 task();
-                mtx.lock();
             } catch (sim_terminated_exception& ex) {
                 (void)ex;
-                mtx.lock();
                 alive = false;
             }
 
             working = false;
+            kernel_bell.ring();
         }
 
-        mtx.unlock();
         g_async = nullptr;
     }
 
     void kill() {
         if (worker.joinable()) {
-            mtx.lock();
             alive = false;
-            mtx.unlock();
-            notify.notify_all();
+            worker_bell.ring();
             worker.join();
         }
     }
 
-    void run_async(function<void(void)>& job) {
-        mtx.lock();
+    void advance(u64 p) {
+        sc_thread_pos = sc_time_stamp().value() + p;
+        sc_core::wait(time_from_value(p));
+        completed += p;
+        worker_bell.ring();
+    }
+
+    void process_requests() {
+        // SystemC needs to catch up with the worker before running its jobs
+        u64 p = progress.exchange(0);
+        if (p > 0)
+            advance(p);
+
+        if (async_sync_job* job = request.exchange(nullptr)) {
+            job->func();
+            job->done = true;
+        }
+
+        worker_bell.ring();
+    }
+
+    void wait_progress() {
+        // give the other SystemC threads resuming at this time a chance to
+        // release their workers before the kernel gets blocked on this one
+        if (!progress && !request)
+            sc_core::wait(SC_ZERO_TIME);
+
+        // block the SystemC thread rather than spinning on delta cycles, so
+        // that the other workers get to use the host cores meanwhile
+        kernel_bell.wait([&]() -> bool {
+            return !working || progress > 0 || request != nullptr;
+        });
+    }
+
+    void wait_barrier() {
+        worker_bell.wait([&]() -> bool {
+            return !alive || !sim_running() || completed >= reported;
+        });
+    }
+
+    void wait_offset(const sc_time& limit) {
+        worker_bell.wait([&]() -> bool {
+            return !alive || !sim_running() ||
+                   timestamp() - sc_time_stamp() < limit;
+        });
+    }
+
+    void run_async(function<void(void)>& job, bool par) {
         task = job;
+        parallel = par;
+        sc_thread_pos = sc_time_stamp().value();
         working = true;
-        mtx.unlock();
-        notify.notify_one();
+        worker_bell.ring();
 
         while (working) {
-            u64 p = progress.exchange(0);
-            sc_thread_pos = sc_time_stamp() + time_from_value(p);
-            sc_core::wait(time_from_value(p));
-
-            if (request) {
-                p = progress.exchange(0);
-                if (p > 0) {
-                    sc_thread_pos = sc_time_stamp() + time_from_value(p);
-                    sc_core::wait(time_from_value(p));
-                }
-
-                (*request)();
-                request = nullptr;
-            }
+            if (parallel)
+                wait_progress();
+
+            advance(progress.exchange(0));
+
+            if (request != nullptr)
+                process_requests();
         }
 
         u64 p = progress.exchange(0);
         if (p > 0)
-            sc_core::wait(time_from_value(p));
+            advance(p);
     }
 
     void run_sync(function<void(void)> job) {
-        g_async->request = &job;
-        while (g_async->request) {
-            if (!g_async->alive || !sim_running())
-                throw sim_terminated_exception();
-            mwr::cpu_yield();
+        async_sync_job req(std::move(job));
+        request = &req;
+
+        kernel_bell.ring();
+        worker_bell.wait([&]() -> bool {
+            return req.done || !alive || !sim_running();
+        });
+
+        if (!req.done) {
+            // withdraw the job, the SystemC thread will not get to it
+            async_sync_job* expected = &req;
+            request.compare_exchange_strong(expected, nullptr);
+            throw sim_terminated_exception();
         }
     }
 
-    sc_time timestamp() { return sc_thread_pos + time_from_value(progress); }
+    void add_progress(u64 p) {
+        progress += p;
+        reported += p;
+        kernel_bell.ring();
+    }
+
+    sc_time timestamp() { return time_from_value(sc_thread_pos + progress); }
 
     typedef unordered_map<sc_process_b*, shared_ptr<async_worker>> map_t;
     static map_t& all_workers() {
@@ -702,16 +803,26 @@ struct async_worker {
     }
 };
 
-void sc_async(function<void(void)> job) {
+void sc_async(function<void(void)> job, bool parallel) {
     auto thread = current_thread();
     VCML_ERROR_ON(!thread, "sc_async must be called from SC_THREAD");
     async_worker& worker = async_worker::lookup(thread);
-    worker.run_async(job);
+    worker.run_async(job, parallel);
 }
 
 void sc_progress(const sc_time& delta) {
     VCML_ERROR_ON(!g_async, "no async thread to progress");
-    g_async->progress += delta.value();
+    g_async->add_progress(delta.value());
+}
+
+void sc_async_barrier() {
+    VCML_ERROR_ON(!g_async, "no async thread to synchronize");
+    g_async->wait_barrier();
+}
+
+void sc_async_wait(const sc_time& limit) {
+    VCML_ERROR_ON(!g_async, "no async thread to synchronize");
+    g_async->wait_offset(limit);
 }
 
 void sc_sync(function<void(void)> job) {
@@ -742,6 +853,16 @@ sc_time async_time_offset() {
     return async_time_stamp() - sc_time_stamp();
 }
 
+static atomic<u64> g_interactions(0);
+
+void notify_interaction() {
+    g_interactions.fetch_add(1, std::memory_order_relaxed);
+}
+
+u64 interaction_count() {
+    return g_interactions.load(std::memory_order_relaxed);
+}
+
 bool is_thread(sc_process_b* proc) {
     if (!thctl_is_sysc_thread())
         return false;
@@ -784,6 +905,36 @@ sc_process_b* current_method() {
     return proc;
 }
 
+// Every process gets a dense index on first use, index zero is reserved for
+// code that runs outside of any process. Each host thread remembers the last
+// translation, so repeated calls from the same process skip the registry.
+static thread_local sc_process_b* g_last_process = nullptr;
+static thread_local size_t g_last_process_index = 0;
+
+size_t process_index(sc_process_b* proc) {
+    if (proc == g_last_process)
+        return g_last_process_index;
+
+    size_t index = 0;
+    if (proc != nullptr) {
+        static mutex mtx;
+        static unordered_map<sc_process_b*, size_t> indices;
+
+        lock_guard<mutex> guard(mtx);
+        auto it = indices.find(proc);
+        if (it != indices.end()) {
+            index = it->second;
+        } else {
+            index = indices.size() + 1;
+            indices[proc] = index;
+        }
+    }
+
+    g_last_process = proc;
+    g_last_process_index = index;
+    return index;
+}
+
 bool is_stop_requested() {
     return sc_core::sc_get_simulator_status() == sc_core::SC_SIM_USER_STOP;
 }
@@ -11,6 +11,11 @@
 #include "vcml/models/block/backend.h"
 #include "vcml/models/block/backend_ram.h"
 #include "vcml/models/block/backend_file.h"
+#include "vcml/models/block/backend_cow.h"
+
+#ifndef MWR_MSVC
+#include "vcml/models/block/backend_posix.h"
+#endif
 
 namespace vcml {
 namespace block {
@@ -24,6 +29,16 @@ size_t backend::remaining() {
     return capacity() - pos();
 }
 
+void backend::readv(const vector<iobuf>& iov) {
+    for (const iobuf& buf : iov)
+        read(buf.ptr, buf.size);
+}
+
+void backend::writev(const vector<iobuf>& iov) {
+    for (const iobuf& buf : iov)
+        write(buf.ptr, buf.size);
+}
+
 void backend::wzero(size_t size, bool may_unmap) {
     static const u8 zero[512] = {};
     while (size > 0) {
@@ -42,6 +57,41 @@ void backend::flush() {
     // nothing to do
 }
 
+bool backend::concurrent() const {
+    return false;
+}
+
+template <typename FN>
+static void access_at(backend& be, size_t off, FN access) {
+    size_t prev = be.pos();
+    be.seek(off);
+
+    try {
+        access();
+    } catch (...) {
+        be.seek(prev);
+        throw;
+    }
+
+    be.seek(prev);
+}
+
+void backend::preadv(size_t off, const vector<iobuf>& iov) {
+    access_at(*this, off, [&]() -> void { readv(iov); });
+}
+
+void backend::pwritev(size_t off, const vector<iobuf>& iov) {
+    access_at(*this, off, [&]() -> void { writev(iov); });
+}
+
+void backend::pwzero(size_t off, size_t size, bool may_unmap) {
+    access_at(*this, off, [&]() -> void { wzero(size, may_unmap); });
+}
+
+void backend::pdiscard(size_t off, size_t size) {
+    access_at(*this, off, [&]() -> void { discard(size); });
+}
+
 static size_t parse_capacity(const string& desc) {
     string s = to_lower(desc);
     char* endptr = nullptr;
@@ -59,6 +109,14 @@ static size_t parse_capacity(const string& desc) {
     VCML_REPORT("invalid ramdisk capacity: %s", s.c_str());
 }
 
+static backend* create_posix(const string& path, bool ro, bool mapped) {
+#ifdef MWR_MSVC
+    return new backend_file(path, ro);
+#else
+    return new backend_posix(path, ro, mapped);
+#endif
+}
+
 backend* backend::create(const string& image, bool readonly) {
     if (image.empty()) // default ramdisk if nothing else was specified
         return new backend_ram(2 * GiB, readonly);
@@ -68,6 +126,20 @@ backend* backend::create(const string& image, bool readonly) {
         return new backend_ram(cap, readonly);
     }
 
+    if (starts_with(image, "cow:")) {
+        vector<string> files = split(image.substr(4), ',');
+        VCML_REPORT_ON(files.empty() || files.size() > 2,
+                       "invalid cow image: %s", image.c_str());
+        string overlay = files.size() > 1 ? files[1] : "";
+        return new backend_cow(files[0], overlay, readonly);
+    }
+
+    if (starts_with(image, "direct:"))
+        return create_posix(image.substr(7), readonly, false);
+
+    if (starts_with(image, "mmap:"))
+        return create_posix(image.substr(5), readonly, true);
+
     // if no image specification is given we test if its just a path
     return new backend_file(image, readonly);
 }
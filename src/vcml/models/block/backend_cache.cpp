@@ -0,0 +1,246 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/block/backend_cache.h"
+
+namespace vcml {
+namespace block {
+
+size_t backend_cache::page_length(size_t idx) const {
+    return min<size_t>(PAGE_SIZE, m_cap - idx * PAGE_SIZE);
+}
+
+backend_cache::page* backend_cache::lookup(size_t idx) {
+    auto it = m_pages.find(idx);
+    if (it == m_pages.end())
+        return nullptr;
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &*it->second;
+}
+
+backend_cache::page& backend_cache::fetch(size_t idx, bool load) {
+    page* p = lookup(idx);
+    if (p != nullptr) {
+        m_hits++;
+        return *p;
+    }
+
+    m_misses++;
+
+    unique_ptr<u8[]> data;
+    if (m_pages.size() >= m_max_pages) {
+        page& victim = m_lru.back();
+        if (victim.dirty)
+            write_back(victim.index);
+        data = std::move(victim.data);
+        m_pages.erase(victim.index);
+        m_lru.pop_back();
+    } else {
+        data = std::make_unique<u8[]>(PAGE_SIZE);
+    }
+
+    if (load) {
+        m_backend->seek(idx * PAGE_SIZE);
+        m_backend->read(data.get(), page_length(idx));
+    }
+
+    m_lru.push_front({ idx, false, std::move(data) });
+    m_pages[idx] = m_lru.begin();
+    return m_lru.front();
+}
+
+void backend_cache::write_run(size_t first, size_t last) {
+    vector<iobuf> iov;
+    iov.reserve(last - first + 1);
+    for (size_t idx = first; idx <= last; idx++) {
+        page& p = *m_pages.at(idx);
+        iov.push_back({ p.data.get(), page_length(idx) });
+        p.dirty = false;
+    }
+
+    m_backend->seek(first * PAGE_SIZE);
+    m_backend->writev(iov);
+    m_writebacks++;
+}
+
+void backend_cache::write_back(size_t idx) {
+    auto is_dirty = [&](size_t i) -> bool {
+        auto it = m_pages.find(i);
+        return it != m_pages.end() && it->second->dirty;
+    };
+
+    // take the dirty neighbors along, so that they share one backend write
+    size_t first = idx, last = idx;
+    while (first > 0 && is_dirty(first - 1))
+        first--;
+    while (is_dirty(last + 1))
+        last++;
+
+    write_run(first, last);
+}
+
+void backend_cache::write_back_all() {
+    vector<size_t> dirty;
+    for (const page& p : m_lru) {
+        if (p.dirty)
+            dirty.push_back(p.index);
+    }
+
+    std::sort(dirty.begin(), dirty.end());
+    for (size_t i = 0; i < dirty.size();) {
+        size_t j = i;
+        while (j + 1 < dirty.size() && dirty[j + 1] == dirty[j] + 1)
+            j++;
+        write_run(dirty[i], dirty[j]);
+        i = j + 1;
+    }
+}
+
+void backend_cache::invalidate(size_t off, size_t size) {
+    if (size == 0 || m_pages.empty())
+        return;
+
+    size_t first = off / PAGE_SIZE;
+    size_t last = (off + size - 1) / PAGE_SIZE;
+
+    vector<size_t> victims;
+    if (last - first + 1 > m_pages.size()) {
+        for (const page& p : m_lru) {
+            if (p.index >= first && p.index <= last)
+                victims.push_back(p.index);
+        }
+    } else {
+        for (size_t idx = first; idx <= last; idx++) {
+            if (m_pages.count(idx))
+                victims.push_back(idx);
+        }
+    }
+
+    // dirty data of partially covered pages must survive, so write it back
+    for (size_t idx : victims) {
+        auto it = m_pages.at(idx);
+        if (it->dirty)
+            write_back(idx);
+        m_lru.erase(it);
+        m_pages.erase(idx);
+    }
+}
+
+backend_cache::backend_cache(backend* base, size_t size, bool wt):
+    backend(base->type(), base->readonly()),
+    m_backend(base),
+    m_writethrough(wt),
+    m_pos(0),
+    m_cap(base->capacity()),
+    m_max_pages(max<size_t>(size / PAGE_SIZE, 1)),
+    m_lru(),
+    m_pages(),
+    m_hits(),
+    m_misses(),
+    m_writebacks() {
+    // nothing to do
+}
+
+backend_cache::~backend_cache() {
+    try {
+        write_back_all();
+    } catch (...) {
+        // disk flushes before destruction and reports errors from there
+    }
+}
+
+size_t backend_cache::capacity() {
+    return m_cap;
+}
+
+size_t backend_cache::pos() {
+    return m_pos;
+}
+
+void backend_cache::seek(size_t pos) {
+    VCML_REPORT_ON(pos > m_cap, "attempt to seek beyond end of buffer");
+    m_pos = pos;
+}
+
+void backend_cache::read(u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "reading beyond end of buffer");
+
+    while (size > 0) {
+        size_t idx = m_pos / PAGE_SIZE;
+        size_t off = m_pos % PAGE_SIZE;
+        size_t n = min(size, page_length(idx) - off);
+
+        page& p = fetch(idx, true);
+        memcpy(buffer, p.data.get() + off, n);
+
+        buffer += n;
+        m_pos += n;
+        size -= n;
+    }
+}
+
+void backend_cache::write(const u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "writing beyond end of buffer");
+
+    if (m_writethrough) {
+        m_backend->seek(m_pos);
+        m_backend->write(buffer, size);
+    }
+
+    while (size > 0) {
+        size_t idx = m_pos / PAGE_SIZE;
+        size_t off = m_pos % PAGE_SIZE;
+        size_t n = min(size, page_length(idx) - off);
+
+        if (m_writethrough) {
+            // only refresh pages that are already cached
+            if (page* p = lookup(idx))
+                memcpy(p->data.get() + off, buffer, n);
+        } else {
+            page& p = fetch(idx, n < page_length(idx));
+            memcpy(p.data.get() + off, buffer, n);
+            p.dirty = true;
+        }
+
+        buffer += n;
+        m_pos += n;
+        size -= n;
+    }
+}
+
+void backend_cache::wzero(size_t size, bool may_unmap) {
+    VCML_REPORT_ON(size > remaining(), "writing beyond end of buffer");
+    invalidate(m_pos, size);
+    m_backend->seek(m_pos);
+    m_backend->wzero(size, may_unmap);
+    m_pos += size;
+}
+
+void backend_cache::discard(size_t size) {
+    VCML_REPORT_ON(size > remaining(), "discarding beyond end of buffer");
+    invalidate(m_pos, size);
+    m_backend->seek(m_pos);
+    m_backend->discard(size);
+    m_pos += size;
+}
+
+void backend_cache::save(ostream& os) {
+    write_back_all();
+    m_backend->save(os);
+}
+
+void backend_cache::flush() {
+    write_back_all();
+    m_backend->flush();
+}
+
+} // namespace block
+} // namespace vcml
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_BLOCK_BACKEND_CACHE_H
+#define VCML_BLOCK_BACKEND_CACHE_H
+
+#include "vcml/core/types.h"
+
+#include "vcml/models/block/backend.h"
+#include "vcml/models/block/stats.h"
+
+namespace vcml {
+namespace block {
+
+// Keeps recently used pages of another backend in memory and evicts them in
+// least-recently-used order. Unless in writethrough mode, writes only dirty
+// the cached pages; runs of adjacent dirty pages are written back together
+// when they get evicted, flushed or saved.
+class backend_cache : public backend
+{
+public:
+    enum : size_t { PAGE_SIZE = 4 * KiB };
+
+protected:
+    struct page {
+        size_t index;
+        bool dirty;
+        unique_ptr<u8[]> data;
+    };
+
+    typedef list<page>::iterator page_ref;
+
+    unique_ptr<backend> m_backend;
+    bool m_writethrough;
+    size_t m_pos;
+    size_t m_cap;
+    size_t m_max_pages;
+
+    list<page> m_lru;
+    unordered_map<size_t, page_ref> m_pages;
+
+    // bumped by disk I/O workers, read by show_stats on the SystemC thread
+    counter m_hits;
+    counter m_misses;
+    counter m_writebacks;
+
+    size_t page_length(size_t idx) const;
+
+    page* lookup(size_t idx);
+    page& fetch(size_t idx, bool load);
+
+    void write_run(size_t first, size_t last);
+    void write_back(size_t idx);
+    void write_back_all();
+    void invalidate(size_t off, size_t size);
+
+public:
+    u64 hits() const { return m_hits; }
+    u64 misses() const { return m_misses; }
+    u64 writebacks() const { return m_writebacks; }
+    size_t cached_pages() const { return m_pages.size(); }
+
+    backend_cache(backend* base, size_t size, bool writethrough);
+    virtual ~backend_cache();
+
+    virtual size_t capacity() override;
+    virtual size_t pos() override;
+
+    virtual void seek(size_t pos) override;
+    virtual void read(u8* buffer, size_t size) override;
+    virtual void write(const u8* buffer, size_t size) override;
+    virtual void wzero(size_t size, bool may_unmap) override;
+    virtual void discard(size_t size) override;
+    virtual void save(ostream& os) override;
+    virtual void flush() override;
+};
+
+} // namespace block
+} // namespace vcml
+
+#endif
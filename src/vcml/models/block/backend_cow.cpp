@@ -0,0 +1,255 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/block/backend_cow.h"
+#include "vcml/models/block/backend_ram.h"
+
+#include <filesystem>
+
+namespace vcml {
+namespace block {
+
+bool backend_cow::is_dirty(size_t blk) const {
+    return (m_map[blk / 64] >> (blk % 64)) & 1;
+}
+
+void backend_cow::set_dirty(size_t blk, bool dirty) {
+    if (dirty)
+        m_map[blk / 64] |= 1ull << (blk % 64);
+    else
+        m_map[blk / 64] &= ~(1ull << (blk % 64));
+}
+
+size_t backend_cow::extent(size_t pos, size_t size, bool& dirty) const {
+    size_t end = pos + size;
+    size_t blk = pos / BLOCK_SIZE;
+    dirty = is_dirty(blk);
+
+    size_t next = (blk + 1) * BLOCK_SIZE;
+    while (next < end && is_dirty(next / BLOCK_SIZE) == dirty)
+        next += BLOCK_SIZE;
+
+    return min(next, end) - pos;
+}
+
+void backend_cow::prepare(size_t pos, size_t size) {
+    // blocks that are only partially overwritten need their base contents
+    // copied into the overlay first
+    vector<size_t> partial;
+    if (pos % BLOCK_SIZE)
+        partial.push_back(pos / BLOCK_SIZE);
+    if ((pos + size) % BLOCK_SIZE && pos + size < m_capacity)
+        partial.push_back((pos + size - 1) / BLOCK_SIZE);
+
+    vector<u8> buffer;
+    for (size_t blk : partial) {
+        if (is_dirty(blk))
+            continue;
+
+        size_t start = blk * BLOCK_SIZE;
+        buffer.resize(min<size_t>(BLOCK_SIZE, m_capacity - start));
+        m_base->seek(start);
+        m_base->read(buffer.data(), buffer.size());
+        m_overlay->seek(start);
+        m_overlay->write(buffer.data(), buffer.size());
+        set_dirty(blk, true);
+    }
+
+    for (size_t blk = pos / BLOCK_SIZE; blk * BLOCK_SIZE < pos + size; blk++)
+        set_dirty(blk, true);
+}
+
+void backend_cow::load_map() {
+    ifstream is(m_mapfile.c_str(), std::ios::binary);
+    VCML_REPORT_ON(!is, "error opening %s: %s", m_mapfile.c_str(),
+                   strerror(errno));
+
+    u64 capacity = 0;
+    is.read((char*)&capacity, sizeof(capacity));
+    VCML_REPORT_ON(capacity != m_capacity, "block map %s does not match",
+                   m_mapfile.c_str());
+
+    is.read((char*)m_map.data(), m_map.size() * sizeof(m_map[0]));
+    VCML_REPORT_ON(!is, "error reading %s", m_mapfile.c_str());
+}
+
+void backend_cow::write_map() {
+    // write a new map next to the old one and replace it only once it is
+    // complete, so that a crash while saving leaves the old map intact
+    string temp = m_mapfile + ".tmp";
+    u64 capacity = m_capacity;
+    ofstream os(temp.c_str(), std::ios::binary);
+    os.write((const char*)&capacity, sizeof(capacity));
+    os.write((const char*)m_map.data(), m_map.size() * sizeof(m_map[0]));
+    os.close();
+    VCML_REPORT_ON(!os, "error writing %s", temp.c_str());
+
+    std::error_code ec;
+    std::filesystem::rename(temp, m_mapfile, ec);
+    VCML_REPORT_ON(ec, "error replacing %s: %s", m_mapfile.c_str(),
+                   ec.message().c_str());
+}
+
+void backend_cow::save_map() {
+    if (m_mapfile.empty() || m_readonly)
+        return;
+
+    write_map();
+}
+
+size_t backend_cow::dirty_blocks() const {
+    size_t n = 0;
+    for (u64 word : m_map)
+        n += popcnt(word);
+    return n;
+}
+
+backend_cow::backend_cow(const string& base, const string& overlay,
+                         bool readonly):
+    backend("cow", readonly),
+    m_mapfile(),
+    m_pos(0),
+    m_capacity(0),
+    m_base(),
+    m_overlay(),
+    m_map() {
+    m_base.reset(backend::create("mmap:" + base, true));
+    m_capacity = m_base->capacity();
+
+    size_t blocks = (m_capacity + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    m_map.resize((blocks + 63) / 64);
+
+    if (overlay.empty()) {
+        m_overlay.reset(new backend_ram(m_capacity, readonly));
+        return;
+    }
+
+    bool fresh = !mwr::file_exists(overlay);
+    if (fresh) {
+        ofstream os(overlay.c_str(), std::ios::binary);
+        VCML_REPORT_ON(!os, "error creating %s: %s", overlay.c_str(),
+                       strerror(errno));
+        os.close();
+        std::filesystem::resize_file(overlay, m_capacity);
+    }
+
+    m_overlay.reset(backend::create("direct:" + overlay, readonly));
+    VCML_REPORT_ON(m_overlay->capacity() != m_capacity,
+                   "overlay %s does not match size of %s", overlay.c_str(),
+                   base.c_str());
+
+    // a fresh overlay gets its (empty) map right away, otherwise a run that
+    // ends before its first flush would leave an overlay without a map
+    m_mapfile = overlay + ".map";
+    if (fresh)
+        write_map();
+    else
+        load_map();
+}
+
+backend_cow::~backend_cow() {
+    try {
+        save_map();
+    } catch (...) {
+        // disk flushes before destruction and reports errors from there
+    }
+}
+
+size_t backend_cow::capacity() {
+    return m_capacity;
+}
+
+size_t backend_cow::pos() {
+    return m_pos;
+}
+
+void backend_cow::seek(size_t pos) {
+    VCML_REPORT_ON(pos > capacity(), "attempt to seek beyond end of buffer");
+    m_pos = pos;
+}
+
+void backend_cow::read(u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "reading beyond end of disk");
+
+    while (size > 0) {
+        bool dirty = false;
+        size_t num = extent(m_pos, size, dirty);
+        backend* src = dirty ? m_overlay.get() : m_base.get();
+        src->seek(m_pos);
+        src->read(buffer, num);
+
+        buffer += num;
+        m_pos += num;
+        size -= num;
+    }
+}
+
+void backend_cow::write(const u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "writing beyond end of disk");
+    if (size == 0)
+        return;
+
+    prepare(m_pos, size);
+    m_overlay->seek(m_pos);
+    m_overlay->write(buffer, size);
+    m_pos += size;
+}
+
+void backend_cow::wzero(size_t size, bool may_unmap) {
+    VCML_REPORT_ON(size > remaining(), "writing beyond end of disk");
+    if (size == 0)
+        return;
+
+    prepare(m_pos, size);
+    m_overlay->seek(m_pos);
+    m_overlay->wzero(size, may_unmap);
+    m_pos += size;
+}
+
+void backend_cow::discard(size_t size) {
+    VCML_REPORT_ON(size > remaining(), "discarding beyond end of disk");
+
+    // fully discarded blocks fall back to the base image
+    size_t start = (m_pos + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    size_t end = (m_pos + size) / BLOCK_SIZE * BLOCK_SIZE;
+    if (m_pos + size == m_capacity)
+        end = m_capacity;
+
+    if (!m_readonly && end > start) {
+        m_overlay->seek(start);
+        m_overlay->discard(end - start);
+        for (size_t blk = start / BLOCK_SIZE; blk * BLOCK_SIZE < end; blk++)
+            set_dirty(blk, false);
+    }
+
+    m_pos += size;
+}
+
+void backend_cow::save(ostream& os) {
+    vector<u8> buffer(1 * MiB);
+    for (size_t pos = 0; pos < m_capacity;) {
+        bool dirty = false;
+        size_t num = extent(pos, min(buffer.size(), m_capacity - pos), dirty);
+        backend* src = dirty ? m_overlay.get() : m_base.get();
+        src->seek(pos);
+        src->read(buffer.data(), num);
+        os.write((const char*)buffer.data(), num);
+        VCML_REPORT_ON(!os, "error saving disk: %s", strerror(errno));
+        pos += num;
+    }
+}
+
+void backend_cow::flush() {
+    m_overlay->flush();
+    save_map();
+}
+
+} // namespace block
+} // namespace vcml
@@ -0,0 +1,71 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_BLOCK_BACKEND_COW_H
+#define VCML_BLOCK_BACKEND_COW_H
+
+#include "vcml/core/types.h"
+
+#include "vcml/models/block/backend.h"
+
+namespace vcml {
+namespace block {
+
+// Copy-on-write overlay: reads come from a shared read-only base image
+// unless the block has been written, in which case the block lives in the
+// overlay. Without an overlay file, written blocks are kept in memory. An
+// overlay file is created sparse and its block map is kept next to it in
+// '<overlay>.map', so it can be reused by later runs on the same base.
+class backend_cow : public backend
+{
+public:
+    enum : size_t {
+        BLOCK_SIZE = 4 * KiB,
+    };
+
+protected:
+    string m_mapfile;
+    size_t m_pos;
+    size_t m_capacity;
+    unique_ptr<backend> m_base;
+    unique_ptr<backend> m_overlay;
+    vector<u64> m_map;
+
+    bool is_dirty(size_t blk) const;
+    void set_dirty(size_t blk, bool dirty);
+    size_t extent(size_t pos, size_t size, bool& dirty) const;
+
+    void prepare(size_t pos, size_t size);
+    void load_map();
+    void write_map();
+    void save_map();
+
+public:
+    size_t dirty_blocks() const;
+
+    backend_cow(const string& base, const string& overlay, bool readonly);
+    virtual ~backend_cow();
+
+    virtual size_t capacity() override;
+    virtual size_t pos() override;
+
+    virtual void seek(size_t pos) override;
+    virtual void read(u8* buffer, size_t size) override;
+    virtual void write(const u8* buffer, size_t size) override;
+    virtual void wzero(size_t size, bool may_unmap) override;
+    virtual void discard(size_t size) override;
+    virtual void save(ostream& os) override;
+    virtual void flush() override;
+};
+
+} // namespace block
+} // namespace vcml
+
+#endif
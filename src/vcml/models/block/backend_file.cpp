@@ -14,7 +14,12 @@ namespace vcml {
 namespace block {
 
 backend_file::backend_file(const string& path, bool readonly):
-    backend("file", readonly), m_path(path), m_stream(), m_capacity() {
+    backend("file", readonly),
+    m_path(path),
+    m_stream(),
+    m_mtx(),
+    m_pos(0),
+    m_capacity() {
     auto flags = std::ios_base::binary | std::ios_base::in;
     if (!readonly)
         flags |= std::ios_base::out;
@@ -37,34 +42,82 @@ size_t backend_file::capacity() {
 }
 
 size_t backend_file::pos() {
-    return m_stream.tellg();
+    return m_pos;
 }
 
 void backend_file::seek(size_t pos) {
     VCML_REPORT_ON(pos > capacity(), "attempt to seek beyond end of buffer");
-    m_stream.seekg(pos);
-    m_stream.seekp(pos);
+    m_pos = pos;
 }
 
 void backend_file::read(u8* buffer, size_t size) {
-    VCML_REPORT_ON(size > remaining(), "reading beyond end of file");
-    m_stream.read((char*)buffer, size);
-    VCML_REPORT_ON(!m_stream, "error reading: %s", strerror(errno));
+    preadv(m_pos, { { buffer, size } });
+    m_pos += size;
 }
 
 void backend_file::write(const u8* buffer, size_t size) {
-    VCML_REPORT_ON(size > remaining(), "writing beyond end of file");
-    m_stream.write((char*)buffer, size);
-    VCML_REPORT_ON(!m_stream, "error writing: %s", strerror(errno));
+    pwritev(m_pos, { { (u8*)buffer, size } });
+    m_pos += size;
 }
 
 void backend_file::save(ostream& os) {
+    lock_guard<mutex> guard(m_mtx);
+    m_stream.seekg(0);
     os << m_stream.rdbuf();
 }
 
 void backend_file::flush() {
+    lock_guard<mutex> guard(m_mtx);
     m_stream << std::flush;
 }
 
+// the stream has only one file position, so every access takes the lock
+// and moves it, while m_pos tracks the position seen by stream users
+bool backend_file::concurrent() const {
+    return true;
+}
+
+void backend_file::preadv(size_t off, const vector<iobuf>& iov) {
+    size_t size = iov_length(iov);
+    VCML_REPORT_ON(off + size > m_capacity, "reading beyond end of file");
+
+    lock_guard<mutex> guard(m_mtx);
+    m_stream.seekg(off);
+    for (const iobuf& buf : iov) {
+        m_stream.read((char*)buf.ptr, buf.size);
+        VCML_REPORT_ON(!m_stream, "error reading: %s", strerror(errno));
+    }
+}
+
+void backend_file::pwritev(size_t off, const vector<iobuf>& iov) {
+    size_t size = iov_length(iov);
+    VCML_REPORT_ON(off + size > m_capacity, "writing beyond end of file");
+
+    lock_guard<mutex> guard(m_mtx);
+    m_stream.seekp(off);
+    for (const iobuf& buf : iov) {
+        m_stream.write((const char*)buf.ptr, buf.size);
+        VCML_REPORT_ON(!m_stream, "error writing: %s", strerror(errno));
+    }
+}
+
+void backend_file::pwzero(size_t off, size_t size, bool may_unmap) {
+    VCML_REPORT_ON(off + size > m_capacity, "writing beyond end of file");
+
+    static const char zero[4 * KiB] = {};
+    lock_guard<mutex> guard(m_mtx);
+    m_stream.seekp(off);
+    while (size > 0) {
+        size_t n = min(size, sizeof(zero));
+        m_stream.write(zero, n);
+        VCML_REPORT_ON(!m_stream, "error writing: %s", strerror(errno));
+        size -= n;
+    }
+}
+
+void backend_file::pdiscard(size_t off, size_t size) {
+    VCML_REPORT_ON(off + size > m_capacity, "discarding beyond end of file");
+}
+
 } // namespace block
 } // namespace vcml
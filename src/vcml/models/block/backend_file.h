@@ -23,6 +23,8 @@ class backend_file : public backend
 protected:
     string m_path;
     fstream m_stream;
+    mutex m_mtx;
+    size_t m_pos;
     size_t m_capacity;
 
 public:
@@ -37,6 +39,13 @@ public:
     virtual void write(const u8* buffer, size_t size) override;
     virtual void save(ostream& os) override;
     virtual void flush() override;
+
+    virtual bool concurrent() const override;
+
+    virtual void preadv(size_t off, const vector<iobuf>& iov) override;
+    virtual void pwritev(size_t off, const vector<iobuf>& iov) override;
+    virtual void pwzero(size_t off, size_t size, bool may_unmap) override;
+    virtual void pdiscard(size_t off, size_t size) override;
 };
 
 } // namespace block
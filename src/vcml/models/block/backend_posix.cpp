@@ -0,0 +1,288 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/block/backend_posix.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace vcml {
+namespace block {
+
+static bool punch_hole(int fd, size_t off, size_t len) {
+#if defined(__linux__)
+    int mode = FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+    return fallocate(fd, mode, off, len) == 0;
+#else
+    return false;
+#endif
+}
+
+static bool zero_range(int fd, size_t off, size_t len) {
+#if defined(__linux__)
+    int mode = FALLOC_FL_ZERO_RANGE | FALLOC_FL_KEEP_SIZE;
+    return fallocate(fd, mode, off, len) == 0;
+#else
+    return false;
+#endif
+}
+
+// issues as few preadv/pwritev calls as possible, resuming after short
+// transfers and splitting lists that exceed the IOV_MAX limit
+static void transfer(int fd, const vector<iobuf>& iov, size_t pos, bool wr) {
+    vector<struct iovec> vec;
+    vec.reserve(iov.size());
+    for (const iobuf& buf : iov) {
+        if (buf.size > 0)
+            vec.push_back({ buf.ptr, buf.size });
+    }
+
+    size_t idx = 0;
+    while (idx < vec.size()) {
+        int cnt = (int)min<size_t>(vec.size() - idx, IOV_MAX);
+        ssize_t n = wr ? pwritev(fd, vec.data() + idx, cnt, pos)
+                       : preadv(fd, vec.data() + idx, cnt, pos);
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        const char* op = wr ? "writing" : "reading";
+        VCML_REPORT_ON(n < 0, "error %s: %s", op, strerror(errno));
+        VCML_REPORT_ON(n == 0, "unexpected end of file");
+
+        pos += n;
+        while (n > 0) {
+            size_t k = min<size_t>(n, vec[idx].iov_len);
+            vec[idx].iov_base = (u8*)vec[idx].iov_base + k;
+            vec[idx].iov_len -= k;
+            if (vec[idx].iov_len == 0)
+                idx++;
+            n -= k;
+        }
+    }
+}
+
+backend_posix::backend_posix(const string& path, bool readonly, bool mapped):
+    backend(mapped ? "mmap" : "direct", readonly),
+    m_path(path),
+    m_fd(-1),
+    m_pos(0),
+    m_capacity(0),
+    m_map(nullptr) {
+    m_fd = open(m_path.c_str(), (readonly ? O_RDONLY : O_RDWR) | O_CLOEXEC);
+    if (m_fd < 0)
+        VCML_REPORT("error opening %s: %s", m_path.c_str(), strerror(errno));
+
+    off_t end = lseek(m_fd, 0, SEEK_END);
+    if (end < 0) {
+        int err = errno;
+        close(m_fd);
+        VCML_REPORT("error sizing %s: %s", m_path.c_str(), strerror(err));
+    }
+
+    m_capacity = (size_t)end;
+    if (mapped && m_capacity > 0) {
+        void* map = mmap(nullptr, m_capacity, PROT_READ, MAP_SHARED, m_fd, 0);
+        if (map == MAP_FAILED) {
+            int err = errno;
+            close(m_fd);
+            VCML_REPORT("error mapping %s: %s", m_path.c_str(), strerror(err));
+        }
+
+        m_map = (u8*)map;
+    }
+}
+
+backend_posix::~backend_posix() {
+    if (m_map)
+        munmap(m_map, m_capacity);
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+size_t backend_posix::capacity() {
+    return m_capacity;
+}
+
+size_t backend_posix::pos() {
+    return m_pos;
+}
+
+void backend_posix::seek(size_t pos) {
+    VCML_REPORT_ON(pos > capacity(), "attempt to seek beyond end of buffer");
+    m_pos = pos;
+}
+
+void backend_posix::read(u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "reading beyond end of file");
+
+    if (m_map) {
+        memcpy(buffer, m_map + m_pos, size);
+        m_pos += size;
+        return;
+    }
+
+    while (size > 0) {
+        ssize_t n = pread(m_fd, buffer, size, m_pos);
+        if (n < 0 && errno == EINTR)
+            continue;
+        VCML_REPORT_ON(n < 0, "error reading: %s", strerror(errno));
+        VCML_REPORT_ON(n == 0, "unexpected end of file");
+        buffer += n;
+        m_pos += n;
+        size -= n;
+    }
+}
+
+void backend_posix::write(const u8* buffer, size_t size) {
+    VCML_REPORT_ON(size > remaining(), "writing beyond end of file");
+
+    while (size > 0) {
+        ssize_t n = pwrite(m_fd, buffer, size, m_pos);
+        if (n < 0 && errno == EINTR)
+            continue;
+        VCML_REPORT_ON(n <= 0, "error writing: %s", strerror(errno));
+        buffer += n;
+        m_pos += n;
+        size -= n;
+    }
+}
+
+void backend_posix::readv(const vector<iobuf>& iov) {
+    preadv(m_pos, iov);
+    m_pos += iov_length(iov);
+}
+
+void backend_posix::writev(const vector<iobuf>& iov) {
+    pwritev(m_pos, iov);
+    m_pos += iov_length(iov);
+}
+
+void backend_posix::wzero(size_t size, bool may_unmap) {
+    pwzero(m_pos, size, may_unmap);
+    m_pos += size;
+}
+
+void backend_posix::discard(size_t size) {
+    pdiscard(m_pos, size);
+    m_pos += size;
+}
+
+bool backend_posix::concurrent() const {
+    return true;
+}
+
+void backend_posix::preadv(size_t off, const vector<iobuf>& iov) {
+    size_t size = iov_length(iov);
+    VCML_REPORT_ON(off + size > m_capacity, "reading beyond end of file");
+
+    if (m_map) {
+        for (const iobuf& buf : iov) {
+            memcpy(buf.ptr, m_map + off, buf.size);
+            off += buf.size;
+        }
+        return;
+    }
+
+    transfer(m_fd, iov, off, false);
+}
+
+void backend_posix::pwritev(size_t off, const vector<iobuf>& iov) {
+    size_t size = iov_length(iov);
+    VCML_REPORT_ON(off + size > m_capacity, "writing beyond end of file");
+    transfer(m_fd, iov, off, true);
+}
+
+void backend_posix::pwzero(size_t off, size_t size, bool may_unmap) {
+    VCML_REPORT_ON(off + size > m_capacity, "writing beyond end of file");
+
+    if ((may_unmap && punch_hole(m_fd, off, size)) ||
+        zero_range(m_fd, off, size)) {
+        return;
+    }
+
+    static const u8 zero[4 * KiB] = {};
+    while (size > 0) {
+        size_t n = min(size, sizeof(zero));
+        transfer(m_fd, { { (u8*)zero, n } }, off, true);
+        off += n;
+        size -= n;
+    }
+}
+
+void backend_posix::pdiscard(size_t off, size_t size) {
+    VCML_REPORT_ON(off + size > m_capacity, "discarding beyond end of file");
+
+    // discarding is only a hint, so failing to punch a hole is not an error
+    if (!m_readonly)
+        punch_hole(m_fd, off, size);
+}
+
+void backend_posix::save(ostream& os) {
+    vector<u8> buffer(1 * MiB);
+    size_t off = 0;
+
+    while (off < m_capacity) {
+        size_t end = m_capacity;
+
+#ifdef SEEK_DATA
+        // only copy extents that hold data, holes stay holes in the output;
+        // without SEEK_DATA support (EINVAL) copy the rest linearly
+        off_t data = lseek(m_fd, off, SEEK_DATA);
+        if (data < 0 && errno == ENXIO)
+            break; // nothing but holes left
+        VCML_REPORT_ON(data < 0 && errno != EINVAL,
+                       "error seeking data: %s", strerror(errno));
+        if (data >= 0) {
+            off_t hole = lseek(m_fd, data, SEEK_HOLE);
+            off = (size_t)data;
+            if (hole > data)
+                end = min(end, (size_t)hole);
+        }
+#endif
+
+        os.seekp(off);
+        while (off < end) {
+            size_t num = min(buffer.size(), end - off);
+            ssize_t n = pread(m_fd, buffer.data(), num, off);
+            if (n < 0 && errno == EINTR)
+                continue;
+            VCML_REPORT_ON(n <= 0, "error reading: %s", strerror(errno));
+            os.write((const char*)buffer.data(), n);
+            VCML_REPORT_ON(!os, "error saving disk: %s", strerror(errno));
+            off += n;
+        }
+    }
+
+    // make sure the saved image has the full size even if it ends in a hole
+    if (m_capacity > 0 && off < m_capacity) {
+        os.seekp(m_capacity - 1);
+        os.put(0);
+        VCML_REPORT_ON(!os, "error saving disk: %s", strerror(errno));
+    }
+}
+
+void backend_posix::flush() {
+    if (m_readonly)
+        return;
+
+#if defined(__APPLE__)
+    int res = fsync(m_fd);
+#else
+    int res = fdatasync(m_fd);
+#endif
+    VCML_REPORT_ON(res < 0, "error flushing: %s", strerror(errno));
+}
+
+} // namespace block
+} // namespace vcml
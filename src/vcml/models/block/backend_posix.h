@@ -0,0 +1,64 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_BLOCK_BACKEND_POSIX_H
+#define VCML_BLOCK_BACKEND_POSIX_H
+
+#include "vcml/core/types.h"
+
+#include "vcml/models/block/backend.h"
+
+namespace vcml {
+namespace block {
+
+// Accesses image files using positional pread/pwrite system calls, so no
+// file offset or stream buffer is shared between requests and positional
+// accesses may run concurrently. With 'mapped', reads are served from a
+// read-only shared mapping of the whole file.
+class backend_posix : public backend
+{
+protected:
+    string m_path;
+    int m_fd;
+    size_t m_pos;
+    size_t m_capacity;
+    u8* m_map;
+
+public:
+    bool is_mapped() const { return m_map != nullptr; }
+
+    backend_posix(const string& path, bool readonly, bool mapped);
+    virtual ~backend_posix();
+
+    virtual size_t capacity() override;
+    virtual size_t pos() override;
+
+    virtual void seek(size_t pos) override;
+    virtual void read(u8* buffer, size_t size) override;
+    virtual void write(const u8* buffer, size_t size) override;
+    virtual void readv(const vector<iobuf>& iov) override;
+    virtual void writev(const vector<iobuf>& iov) override;
+    virtual void wzero(size_t size, bool may_unmap) override;
+    virtual void discard(size_t size) override;
+    virtual void save(ostream& os) override;
+    virtual void flush() override;
+
+    virtual bool concurrent() const override;
+
+    virtual void preadv(size_t off, const vector<iobuf>& iov) override;
+    virtual void pwritev(size_t off, const vector<iobuf>& iov) override;
+    virtual void pwzero(size_t off, size_t size, bool may_unmap) override;
+    virtual void pdiscard(size_t off, size_t size) override;
+};
+
+} // namespace block
+} // namespace vcml
+
+#endif
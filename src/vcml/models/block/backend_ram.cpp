@@ -13,13 +13,41 @@
 namespace vcml {
 namespace block {
 
+u8* backend_ram::lookup(size_t idx) const {
+    const table& tab = m_tables[idx / TABLE_SIZE];
+    return tab ? tab[idx % TABLE_SIZE].get() : nullptr;
+}
+
+u8* backend_ram::allocate(size_t idx) {
+    table& tab = m_tables[idx / TABLE_SIZE];
+    if (!tab)
+        tab.reset(new chunk[TABLE_SIZE]());
+
+    chunk& c = tab[idx % TABLE_SIZE];
+    if (!c) {
+        c.reset(new u8[CHUNK_SIZE]());
+        m_chunks++;
+    }
+
+    return c.get();
+}
+
+void backend_ram::release(size_t idx) {
+    table& tab = m_tables[idx / TABLE_SIZE];
+    if (tab && tab[idx % TABLE_SIZE]) {
+        tab[idx % TABLE_SIZE].reset();
+        m_chunks--;
+    }
+}
+
 backend_ram::backend_ram(size_t cap, bool readonly):
-    backend("ramdisk", readonly), m_pos(), m_cap(cap), m_sectors() {
+    backend("ramdisk", readonly), m_pos(), m_cap(cap), m_chunks(), m_tables() {
+    size_t chunks = (cap + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    m_tables.resize((chunks + TABLE_SIZE - 1) / TABLE_SIZE);
 }
 
 backend_ram::~backend_ram() {
-    for (const auto& sector : m_sectors)
-        delete[] sector.second;
+    // nothing to do
 }
 
 size_t backend_ram::capacity() {
@@ -39,18 +67,17 @@ void backend_ram::read(u8* buffer, size_t size) {
     if (m_pos + size > m_cap)
         VCML_REPORT("attempt to read beyond end of buffer");
 
-    size_t done = 0;
-    while (done < size) {
-        size_t off = m_pos % SECTOR_SIZE;
-        size_t num = min(SECTOR_SIZE - off, size - done);
-        auto it = m_sectors.find(m_pos / SECTOR_SIZE);
-        if (it == m_sectors.end())
-            memset(buffer + done, 0, num);
+    while (size > 0) {
+        size_t off = m_pos % CHUNK_SIZE;
+        size_t num = min(CHUNK_SIZE - off, size);
+        if (const u8* c = lookup(m_pos / CHUNK_SIZE))
+            memcpy(buffer, c + off, num);
         else
-            memcpy(buffer + done, it->second + off, num);
+            memset(buffer, 0, num);
 
-        done += num;
+        buffer += num;
         m_pos += num;
+        size -= num;
     }
 }
 
@@ -58,17 +85,14 @@ void backend_ram::write(const u8* buffer, size_t size) {
     if (m_pos + size > m_cap)
         VCML_REPORT("attempt to write beyond end of buffer");
 
-    size_t done = 0;
-    while (done < size) {
-        size_t off = m_pos % SECTOR_SIZE;
-        size_t num = min(SECTOR_SIZE - off, size - done);
-        u8*& sector = m_sectors[m_pos / SECTOR_SIZE];
-        if (!sector)
-            sector = new u8[SECTOR_SIZE]();
+    while (size > 0) {
+        size_t off = m_pos % CHUNK_SIZE;
+        size_t num = min(CHUNK_SIZE - off, size);
+        memcpy(allocate(m_pos / CHUNK_SIZE) + off, buffer, num);
 
-        memcpy(sector + off, buffer + done, num);
+        buffer += num;
         m_pos += num;
-        done += num;
+        size -= num;
     }
 }
 
@@ -76,25 +100,19 @@ void backend_ram::wzero(size_t size, bool may_unmap) {
     if (m_pos + size > m_cap)
         VCML_REPORT("attempt to write beyond end of buffer");
 
-    size_t done = 0;
-    while (done < size) {
-        size_t off = m_pos % SECTOR_SIZE;
-        size_t num = min(SECTOR_SIZE - off, size - done);
-
-        if (num == SECTOR_SIZE && may_unmap) {
-            discard(SECTOR_SIZE);
-            done += SECTOR_SIZE;
-            continue;
-        }
+    while (size > 0) {
+        size_t off = m_pos % CHUNK_SIZE;
+        size_t num = min(CHUNK_SIZE - off, size);
+        size_t idx = m_pos / CHUNK_SIZE;
 
-        u8*& sector = m_sectors[m_pos / SECTOR_SIZE];
-        if (!sector)
-            sector = new u8[SECTOR_SIZE]();
-        else
-            memset(sector + off, 0, num);
+        // unallocated chunks already read as zero
+        if (num == CHUNK_SIZE && may_unmap)
+            release(idx);
+        else if (u8* c = lookup(idx))
+            memset(c + off, 0, num);
 
-        m_pos += size;
-        done += size;
+        m_pos += num;
+        size -= num;
     }
 }
 
@@ -102,26 +120,32 @@ void backend_ram::discard(size_t size) {
     if (m_pos + size > m_cap)
         VCML_REPORT("attempt to discard beyond end of buffer");
 
-    size_t done = 0;
-    while (done < size) {
-        size_t off = m_pos % SECTOR_SIZE;
-        size_t num = min(SECTOR_SIZE - off, size - done);
-
-        auto it = m_sectors.find(m_pos / SECTOR_SIZE);
-        if (it != m_sectors.end() && num == SECTOR_SIZE) {
-            delete[] it->second;
-            m_sectors.erase(it);
-        }
+    while (size > 0) {
+        size_t off = m_pos % CHUNK_SIZE;
+        size_t num = min(CHUNK_SIZE - off, size);
+        if (num == CHUNK_SIZE)
+            release(m_pos / CHUNK_SIZE);
 
-        m_pos += size;
-        done += size;
+        m_pos += num;
+        size -= num;
     }
 }
 
 void backend_ram::save(ostream& os) {
-    for (const auto& sector : m_sectors) {
-        os.seekp(sector.first * SECTOR_SIZE);
-        os.write((char*)sector.second, SECTOR_SIZE);
+    size_t chunks = (m_cap + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    for (size_t idx = 0; idx < chunks; idx++) {
+        if (!m_tables[idx / TABLE_SIZE]) {
+            idx += TABLE_SIZE - 1 - idx % TABLE_SIZE;
+            continue;
+        }
+
+        const u8* c = lookup(idx);
+        if (c == nullptr)
+            continue;
+
+        size_t off = idx * CHUNK_SIZE;
+        os.seekp(off);
+        os.write((const char*)c, min<size_t>(CHUNK_SIZE, m_cap - off));
         VCML_REPORT_ON(!os, "error saving disk: %s", strerror(errno));
     }
 }
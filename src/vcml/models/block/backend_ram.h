@@ -20,18 +20,28 @@ namespace block {
 
 class backend_ram : public backend
 {
-protected:
+public:
     enum : size_t {
-        SECTOR_SIZE = 512,
+        CHUNK_SIZE = 64 * KiB,
+        TABLE_SIZE = 1024,
     };
 
+protected:
+    typedef unique_ptr<u8[]> chunk;
+    typedef unique_ptr<chunk[]> table;
+
     size_t m_pos;
     size_t m_cap;
-    std::map<u64, u8*> m_sectors;
+    size_t m_chunks;
+    vector<table> m_tables;
 
-    u8* get_page(u64 addr);
+    u8* lookup(size_t idx) const;
+    u8* allocate(size_t idx);
+    void release(size_t idx);
 
 public:
+    size_t footprint() const { return m_chunks * CHUNK_SIZE; }
+
     backend_ram(size_t cap, bool readonly);
     virtual ~backend_ram();
 
@@ -9,17 +9,140 @@
  ******************************************************************************/
 
 #include "vcml/models/block/disk.h"
+#include "vcml/models/block/backend_cache.h"
 
 namespace vcml {
 namespace block {
 
+// Read-only attribute that renders the current statistics as JSON, so that
+// they can be queried via the geta command of the session protocol.
+class disk::stats_attribute : public property_base
+{
+private:
+    disk& m_disk;
+    mutable string m_str;
+
+public:
+    stats_attribute(disk& parent):
+        property_base(&parent, "stats"), m_disk(parent), m_str() {}
+
+    virtual void reset() override {}
+
+    virtual const char* str() const override {
+        stringstream ss;
+        m_disk.write_stats(ss, true);
+        m_str = ss.str();
+        return m_str.c_str();
+    }
+
+    virtual void str(const string& s) override {
+        m_disk.log_warn("attempt to write read-only attribute stats");
+    }
+
+    virtual size_t size() const override { return 0; }
+    virtual size_t count() const override { return 1; }
+    virtual const char* type() const override { return "string"; }
+};
+
+static double throughput(size_t bytes, double seconds) {
+    return seconds > 0.0 ? bytes / (double)MiB / seconds : 0.0;
+}
+
+vector<pair<string, string>> disk::collect_stats() {
+    double sim = time_to_ns(sc_time_stamp()) / 1e9;
+    double host = (latency_histogram::now_ns() - m_host_start) / 1e9;
+
+    vector<pair<string, string>> fields = {
+        { "sim_time", mkstr("%.6f", sim) },
+        { "host_time", mkstr("%.6f", host) },
+        { "bytes_read", to_string(stats.num_bytes_read) },
+        { "bytes_written", to_string(stats.num_bytes_written) },
+        { "read_req", to_string(stats.num_read_req) },
+        { "write_req", to_string(stats.num_write_req) },
+        { "flush_req", to_string(stats.num_flush_req) },
+        { "discard_req", to_string(stats.num_discard_req) },
+        { "errors", to_string(stats.num_err) },
+        { "seq_req", to_string(stats.num_seq_req) },
+        { "rand_req", to_string(stats.num_rand_req) },
+        { "queue_depth", to_string(m_in_flight) },
+        { "max_queue_depth", to_string(stats.max_queue_depth) },
+        { "read_mibps_sim",
+          mkstr("%.3f", throughput(stats.num_bytes_read, sim)) },
+        { "write_mibps_sim",
+          mkstr("%.3f", throughput(stats.num_bytes_written, sim)) },
+        { "read_mibps_host",
+          mkstr("%.3f", throughput(stats.num_bytes_read, host)) },
+        { "write_mibps_host",
+          mkstr("%.3f", throughput(stats.num_bytes_written, host)) },
+    };
+
+    const pair<const char*, const latency_histogram*> latencies[] = {
+        { "read", &stats.lat_read },
+        { "write", &stats.lat_write },
+        { "flush", &stats.lat_flush },
+        { "discard", &stats.lat_discard },
+    };
+
+    for (const auto& [op, lat] : latencies) {
+        string prefix = mkstr("%s_lat_", op);
+        u64 p50 = lat->percentile_ns(50);
+        u64 p99 = lat->percentile_ns(99);
+        fields.push_back({ prefix + "mean_ns", to_string(lat->mean_ns()) });
+        fields.push_back({ prefix + "p50_ns", to_string(p50) });
+        fields.push_back({ prefix + "p99_ns", to_string(p99) });
+        fields.push_back({ prefix + "max_ns", to_string(lat->max_ns()) });
+    }
+
+    return fields;
+}
+
+void disk::write_stats(ostream& os, bool json) {
+    auto fields = collect_stats();
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (i > 0)
+            os << ",";
+        if (json)
+            os << (i ? "" : "{") << "\"" << fields[i].first << "\":";
+        os << fields[i].second;
+    }
+
+    if (json)
+        os << "}";
+}
+
+void disk::dump_stats() {
+    next_trigger(stats_interval);
+
+    if (!m_stats_json && m_stats_rows++ == 0) {
+        auto fields = collect_stats();
+        for (size_t i = 0; i < fields.size(); i++)
+            m_stats_stream << (i ? "," : "") << fields[i].first;
+        m_stats_stream << std::endl;
+    }
+
+    write_stats(m_stats_stream, m_stats_json);
+    m_stats_stream << std::endl;
+}
+
+static void print_latency(ostream& os, const char* name,
+                          const latency_histogram& lat) {
+    os << name << "mean " << lat.mean_ns() << "ns, p50 "
+       << lat.percentile_ns(50) << "ns, p99 " << lat.percentile_ns(99)
+       << "ns, max " << lat.max_ns() << "ns" << std::endl;
+}
+
 bool disk::cmd_show_stats(const vector<string>& args, ostream& os) {
+    double sim = time_to_ns(sc_time_stamp()) / 1e9;
+    double host = (latency_histogram::now_ns() - m_host_start) / 1e9;
+    size_t rd = stats.num_bytes_read;
+    size_t wr = stats.num_bytes_written;
+
     os << "bytes read       " << stats.num_bytes_read << std::endl;
     os << "bytes written    " << stats.num_bytes_written << std::endl;
     os << "seek requests    " << stats.num_seek_req << std::endl;
     os << "read requests    " << stats.num_read_req << std::endl;
     os << "write requests   " << stats.num_write_req << std::endl;
-    os << "flush requests   " << stats.num_write_req << std::endl;
+    os << "flush requests   " << stats.num_flush_req << std::endl;
     os << "discard requests " << stats.num_discard_req << std::endl;
     os << "total requests   " << stats.num_req << std::endl;
     os << "seek errors      " << stats.num_seek_err << std::endl;
@@ -28,11 +151,37 @@ bool disk::cmd_show_stats(const vector<string>& args, ostream& os) {
     os << "flush errors     " << stats.num_flush_err << std::endl;
     os << "discard errors   " << stats.num_discard_err << std::endl;
     os << "total errors     " << stats.num_err << std::endl;
+    os << "sequential       " << stats.num_seq_req << std::endl;
+    os << "random           " << stats.num_rand_req << std::endl;
+    os << "queue depth      " << m_in_flight << " (max "
+       << stats.max_queue_depth << ")" << std::endl;
+    os << mkstr("read rate        %.3f MiB/s sim, %.3f MiB/s host",
+                throughput(rd, sim), throughput(rd, host))
+       << std::endl;
+    os << mkstr("write rate       %.3f MiB/s sim, %.3f MiB/s host",
+                throughput(wr, sim), throughput(wr, host))
+       << std::endl;
+    print_latency(os, "read latency     ", stats.lat_read);
+    print_latency(os, "write latency    ", stats.lat_write);
+    print_latency(os, "flush latency    ", stats.lat_flush);
+    print_latency(os, "discard latency  ", stats.lat_discard);
+
+    if (m_cache) {
+        os << "cache hits       " << m_cache->hits() << std::endl;
+        os << "cache misses     " << m_cache->misses() << std::endl;
+        os << "cache writebacks " << m_cache->writebacks() << std::endl;
+    }
+
     return true;
 }
 
 bool disk::cmd_save_image(const vector<string>& args, ostream& os) {
-    const string& file = args[1];
+    if (!m_backend) {
+        os << "disk has no backing image";
+        return false;
+    }
+
+    const string& file = args[0];
     ofstream stream(file.c_str(), ofstream::binary);
     if (!stream.good()) {
         os << mkstr("cannot open '%s'", file.c_str());
@@ -48,6 +197,19 @@ bool disk::cmd_save_image(const vector<string>& args, ostream& os) {
     }
 }
 
+static bool parse_policy(const string& s, disk::flush_policy& policy) {
+    string str = to_lower(s);
+    if (str == "writeback")
+        policy = disk::FLUSH_WRITEBACK;
+    else if (str == "writethrough")
+        policy = disk::FLUSH_WRITETHROUGH;
+    else if (str == "unsafe")
+        policy = disk::FLUSH_UNSAFE;
+    else
+        return false;
+    return true;
+}
+
 static string default_serial() {
     static size_t n = 0;
     return mkstr("vcml-disk-%zu", n++);
@@ -56,36 +218,238 @@ static string default_serial() {
 disk::disk(const sc_module_name& nm, const string& img, bool ro):
     module(nm),
     m_backend(nullptr),
+    m_cache(nullptr),
+    m_policy(FLUSH_WRITEBACK),
+    m_next_pos(0),
+    m_host_start(latency_histogram::now_ns()),
+    m_stats_attr(),
+    m_stats_stream(),
+    m_stats_json(false),
+    m_stats_rows(0),
+    m_io_mtx(),
+    m_queue_mtx(),
+    m_queue_cv(),
+    m_done_cv(),
+    m_queue(),
+    m_done(),
+    m_in_flight(0),
+    m_running(true),
+    m_workers(),
+    m_done_ev("done_ev"),
     stats(),
     image("image", img),
     serial("serial", default_serial()),
-    readonly("readonly", ro) {
+    readonly("readonly", ro),
+    io_threads("io_threads", 0),
+    cache_size("cache_size", 0),
+    cache_policy("cache_policy", "writeback"),
+    stats_file("stats_file", ""),
+    stats_interval("stats_interval", sc_time(100.0, SC_MS)) {
+    if (!parse_policy(cache_policy, m_policy)) {
+        log_warn("unknown cache policy '%s', using writeback",
+                 cache_policy.c_str());
+    }
+
     try {
         m_backend = backend::create(image, readonly);
         readonly = !m_backend || m_backend->readonly();
     } catch (std::exception& ex) {
         log_warn("%s", ex.what());
     }
+
+    if (m_backend && cache_size > 0) {
+        bool wt = m_policy == FLUSH_WRITETHROUGH;
+        m_backend = m_cache = new backend_cache(m_backend, cache_size, wt);
+    }
+
+    m_stats_attr = std::make_unique<stats_attribute>(*this);
+
+    register_command("show_stats", 0, &disk::cmd_show_stats,
+                     "shows statistics about the accesses to this disk");
+    register_command("save_image", 1, &disk::cmd_save_image,
+                     "save_image <file> writes the current disk contents "
+                     "to the given file");
+
+    for (size_t i = 0; i < io_threads; i++)
+        m_workers.emplace_back(&disk::worker, this, i);
+
+    SC_HAS_PROCESS(disk);
+    SC_METHOD(complete_requests);
+    sensitive << m_done_ev;
+    dont_initialize();
+
+    // a zero interval would retrigger dump_stats forever without time ever
+    // advancing, so it is rejected rather than stalling the simulation
+    if (!stats_file.get().empty() && stats_interval.get() == SC_ZERO_TIME) {
+        log_warn("stats_interval must be positive, ignoring stats_file");
+    } else if (!stats_file.get().empty()) {
+        m_stats_json = ends_with(stats_file, ".json");
+        m_stats_stream.open(stats_file);
+        if (m_stats_stream.good())
+            SC_METHOD(dump_stats);
+        else
+            log_warn("cannot open stats file '%s'", stats_file.c_str());
+    }
 }
 
 disk::~disk() {
+    {
+        lock_guard<mutex> guard(m_queue_mtx);
+        m_running = false;
+        m_queue_cv.notify_all();
+    }
+
+    for (thread& t : m_workers)
+        t.join();
+
+    // backends may hold state that only reaches the host when flushed,
+    // e.g. cached pages or copy-on-write block maps
+    try {
+        if (m_backend && !m_backend->readonly())
+            m_backend->flush();
+    } catch (std::exception& ex) {
+        log.warn(ex);
+    }
+
     if (m_backend)
         delete m_backend;
 }
 
+// positional accesses leave the position of synchronous users alone, so
+// they only need the lock if the backend cannot run them concurrently
+std::unique_lock<std::recursive_mutex> disk::lock_io() {
+    std::unique_lock<std::recursive_mutex> lock(m_io_mtx, std::defer_lock);
+    if (!m_backend || !m_backend->concurrent())
+        lock.lock();
+    return lock;
+}
+
+void disk::execute(request& req) {
+    switch (req.type) {
+    case REQ_READ:
+        req.success = preadv(req.offset, req.iov);
+        break;
+    case REQ_WRITE:
+        req.success = pwritev(req.offset, req.iov);
+        break;
+    case REQ_WZERO:
+        req.success = pwzero(req.offset, req.size, req.may_unmap);
+        break;
+    case REQ_DISCARD:
+        req.success = pdiscard(req.offset, req.size);
+        break;
+    case REQ_FLUSH:
+        req.success = flush();
+        break;
+    default:
+        VCML_ERROR("invalid disk request type: %d", (int)req.type);
+    }
+}
+
+void disk::worker(size_t id) {
+    mwr::set_thread_name(mkstr("disk_io_%zu", id));
+
+    while (true) {
+        request* req = nullptr;
+
+        {
+            std::unique_lock<mutex> lock(m_queue_mtx);
+            m_queue_cv.wait(lock, [&]() -> bool {
+                return !m_running || !m_queue.empty();
+            });
+
+            if (m_queue.empty())
+                return;
+
+            req = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        execute(*req);
+
+        lock_guard<mutex> guard(m_queue_mtx);
+        m_done.push_back(req);
+        m_done_cv.notify_all();
+        on_next_update([this]() -> void { m_done_ev.notify(SC_ZERO_TIME); });
+    }
+}
+
+void disk::complete(request& req) {
+    // the callback may release the request, so it must not run from there
+    function<void(request&)> callback = std::move(req.complete);
+    if (callback)
+        callback(req);
+}
+
+void disk::complete_requests() {
+    vector<request*> done;
+
+    {
+        lock_guard<mutex> guard(m_queue_mtx);
+        done.swap(m_done);
+    }
+
+    for (request* req : done) {
+        m_in_flight--;
+        complete(*req);
+    }
+}
+
+void disk::submit(request& req) {
+    if (m_workers.empty()) {
+        execute(req);
+        complete(req);
+        return;
+    }
+
+    lock_guard<mutex> guard(m_queue_mtx);
+    m_in_flight++;
+    stats.max_queue_depth.update_max(m_in_flight);
+    m_queue.push_back(&req);
+    m_queue_cv.notify_one();
+}
+
+void disk::drain() {
+    std::unique_lock<mutex> lock(m_queue_mtx);
+    for (request* req : m_queue) {
+        req->success = false;
+        m_done.push_back(req);
+    }
+
+    m_queue.clear();
+    m_done_cv.wait(lock, [&]() -> bool {
+        return m_done.size() == m_in_flight;
+    });
+    lock.unlock();
+
+    complete_requests();
+}
+
+void disk::classify(size_t pos, size_t size) {
+    size_t prev = m_next_pos.exchange(pos + size, std::memory_order_relaxed);
+    if (pos == prev)
+        stats.num_seq_req++;
+    else
+        stats.num_rand_req++;
+}
+
 size_t disk::capacity() {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     return m_backend ? m_backend->capacity() : 0;
 }
 
 size_t disk::pos() {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     return m_backend ? m_backend->pos() : 0;
 }
 
 size_t disk::remaining() {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     return m_backend ? m_backend->remaining() : 0;
 }
 
 bool disk::seek(size_t pos) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     stats.num_seek_req++;
     stats.num_req++;
 
@@ -104,12 +468,16 @@ bool disk::seek(size_t pos) {
 }
 
 bool disk::read(u8* buffer, size_t size) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     stats.num_read_req++;
     stats.num_req++;
 
     if (m_backend) {
         try {
+            classify(m_backend->pos(), size);
+            u64 start = latency_histogram::now_ns();
             m_backend->read(buffer, size);
+            stats.lat_read.record(latency_histogram::now_ns() - start);
             stats.num_bytes_read += size;
             return true;
         } catch (std::exception& ex) {
@@ -123,13 +491,67 @@ bool disk::read(u8* buffer, size_t size) {
 }
 
 bool disk::write(const u8* buffer, size_t size) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     stats.num_write_req++;
     stats.num_req++;
 
     if (m_backend) {
         try {
             if (!m_backend->readonly()) {
+                classify(m_backend->pos(), size);
+                u64 start = latency_histogram::now_ns();
                 m_backend->write(buffer, size);
+                stats.lat_write.record(latency_histogram::now_ns() - start);
+                stats.num_bytes_written += size;
+            }
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_write_err++;
+    stats.num_err++;
+    return false;
+}
+
+bool disk::readv(const vector<iobuf>& iov) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
+    stats.num_read_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            size_t size = iov_length(iov);
+            classify(m_backend->pos(), size);
+            u64 start = latency_histogram::now_ns();
+            m_backend->readv(iov);
+            stats.lat_read.record(latency_histogram::now_ns() - start);
+            stats.num_bytes_read += size;
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_read_err++;
+    stats.num_err++;
+    return false;
+}
+
+bool disk::writev(const vector<iobuf>& iov) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
+    stats.num_write_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            if (!m_backend->readonly()) {
+                size_t size = iov_length(iov);
+                classify(m_backend->pos(), size);
+                u64 start = latency_histogram::now_ns();
+                m_backend->writev(iov);
+                stats.lat_write.record(latency_histogram::now_ns() - start);
                 stats.num_bytes_written += size;
             }
             return true;
@@ -144,13 +566,17 @@ bool disk::write(const u8* buffer, size_t size) {
 }
 
 bool disk::wzero(size_t size, bool may_unmap) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     stats.num_write_req++;
     stats.num_req++;
 
     if (m_backend) {
         try {
             if (!m_backend->readonly()) {
+                classify(m_backend->pos(), size);
+                u64 start = latency_histogram::now_ns();
                 m_backend->wzero(size, may_unmap);
+                stats.lat_write.record(latency_histogram::now_ns() - start);
                 stats.num_bytes_written += size;
             }
             return true;
@@ -165,12 +591,15 @@ bool disk::wzero(size_t size, bool may_unmap) {
 }
 
 bool disk::discard(size_t size) {
+    lock_guard<std::recursive_mutex> guard(m_io_mtx);
     stats.num_discard_req++;
     stats.num_req++;
 
     if (m_backend) {
         try {
+            u64 start = latency_histogram::now_ns();
             m_backend->discard(size);
+            stats.lat_discard.record(latency_histogram::now_ns() - start);
             return true;
         } catch (std::exception& ex) {
             log.warn(ex);
@@ -183,12 +612,19 @@ bool disk::discard(size_t size) {
 }
 
 bool disk::flush() {
+    auto guard = lock_io();
     stats.num_flush_req++;
     stats.num_req++;
 
+    // unsafe mode leaves dirty data to eviction, saving and shutdown
+    if (m_backend && m_policy == FLUSH_UNSAFE)
+        return true;
+
     if (m_backend) {
         try {
+            u64 start = latency_histogram::now_ns();
             m_backend->flush();
+            stats.lat_flush.record(latency_histogram::now_ns() - start);
             return true;
         } catch (std::exception& ex) {
             log.warn(ex);
@@ -200,5 +636,101 @@ bool disk::flush() {
     return false;
 }
 
+bool disk::preadv(size_t off, const vector<iobuf>& iov) {
+    auto guard = lock_io();
+    stats.num_read_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            size_t size = iov_length(iov);
+            classify(off, size);
+            u64 start = latency_histogram::now_ns();
+            m_backend->preadv(off, iov);
+            stats.lat_read.record(latency_histogram::now_ns() - start);
+            stats.num_bytes_read += size;
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_read_err++;
+    stats.num_err++;
+    return false;
+}
+
+bool disk::pwritev(size_t off, const vector<iobuf>& iov) {
+    auto guard = lock_io();
+    stats.num_write_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            if (!m_backend->readonly()) {
+                size_t size = iov_length(iov);
+                classify(off, size);
+                u64 start = latency_histogram::now_ns();
+                m_backend->pwritev(off, iov);
+                stats.lat_write.record(latency_histogram::now_ns() - start);
+                stats.num_bytes_written += size;
+            }
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_write_err++;
+    stats.num_err++;
+    return false;
+}
+
+bool disk::pwzero(size_t off, size_t size, bool may_unmap) {
+    auto guard = lock_io();
+    stats.num_write_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            if (!m_backend->readonly()) {
+                classify(off, size);
+                u64 start = latency_histogram::now_ns();
+                m_backend->pwzero(off, size, may_unmap);
+                stats.lat_write.record(latency_histogram::now_ns() - start);
+                stats.num_bytes_written += size;
+            }
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_write_err++;
+    stats.num_err++;
+    return false;
+}
+
+bool disk::pdiscard(size_t off, size_t size) {
+    auto guard = lock_io();
+    stats.num_discard_req++;
+    stats.num_req++;
+
+    if (m_backend) {
+        try {
+            u64 start = latency_histogram::now_ns();
+            m_backend->pdiscard(off, size);
+            stats.lat_discard.record(latency_histogram::now_ns() - start);
+            return true;
+        } catch (std::exception& ex) {
+            log.warn(ex);
+        }
+    }
+
+    stats.num_discard_err++;
+    stats.num_err++;
+    return false;
+}
+
 } // namespace block
 } // namespace vcml
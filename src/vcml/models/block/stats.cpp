@@ -0,0 +1,59 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/block/stats.h"
+
+#include <chrono>
+
+namespace vcml {
+namespace block {
+
+latency_histogram::latency_histogram():
+    m_buckets(), m_count(0), m_total(0), m_max(0) {
+    // nothing to do
+}
+
+u64 latency_histogram::mean_ns() const {
+    u64 n = count();
+    return n ? total_ns() / n : 0;
+}
+
+u64 latency_histogram::percentile_ns(double p) const {
+    u64 n = count();
+    if (n == 0)
+        return 0;
+
+    // report the upper bound of the bucket that holds the percentile
+    u64 rank = (u64)(p / 100.0 * n + 0.5);
+    u64 seen = 0;
+    for (size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += bucket(i);
+        if (seen >= rank && seen > 0)
+            return min<u64>((2ull << i) - 1, max_ns());
+    }
+
+    return max_ns();
+}
+
+void latency_histogram::reset() {
+    for (auto& b : m_buckets)
+        b.store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+u64 latency_histogram::now_ns() {
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+} // namespace block
+} // namespace vcml
@@ -792,13 +792,13 @@ void m_can::rxthread() {
             set_field<BUF_HDR1_DLC>(rx_buf_elem_hdr[1], rx.dlc);
 
             addr += put_idx * (RX_BUF_ELEM_HDR_SZ + m_rx_fifo0_elem_data_sz);
-            if (failed(dma.writew(addr, rx_buf_elem_hdr))) {
-                log_warn("DMA access failed at 0x%llx", addr);
-                break;
-            }
+            const tlm_iovec iov[] = {
+                { addr, rx_buf_elem_hdr, sizeof(rx_buf_elem_hdr) },
+                { addr + RX_BUF_ELEM_HDR_SZ, rx.data,
+                  (unsigned int)m_rx_fifo0_elem_data_sz },
+            };
 
-            addr += RX_BUF_ELEM_HDR_SZ;
-            if (failed(dma.write(addr, rx.data, m_rx_fifo0_elem_data_sz))) {
+            if (failed(dma.access_vectored(TLM_WRITE_COMMAND, iov, 2))) {
                 log_warn("DMA access failed at 0x%llx", addr);
                 break;
             }
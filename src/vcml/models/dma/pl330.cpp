@@ -826,10 +826,10 @@ static u32 process_read_queue(pl330& dma, pl330::channel& channel) {
                 dma.log.error("DMA channel read failed");
         } else {
             // stream I/O reads
-            tlm_generic_payload tx;
-            tx_setup(tx, TLM_READ_COMMAND, insn.data_addr, data, len);
-            tx.set_streaming_width(insn.data_len);
-            if (failed(dma.dma.send(tx)))
+            tlm_pooled_tx tx(dma.tx_pool());
+            tx_setup(*tx, TLM_READ_COMMAND, insn.data_addr, data, len);
+            tx->set_streaming_width(insn.data_len);
+            if (failed(dma.dma.send(*tx)))
                 dma.log.error("DMA channel read failed");
         }
 
@@ -868,10 +868,10 @@ static u32 process_write_queue(pl330& dma, pl330::channel& channel) {
                 dma.log.error("DMA channel write failed");
         } else {
             // stream I/O writes
-            tlm_generic_payload tx;
-            tx_setup(tx, TLM_WRITE_COMMAND, insn.data_addr, data, len);
-            tx.set_streaming_width(insn.data_len);
-            if (failed(dma.dma.send(tx)))
+            tlm_pooled_tx tx(dma.tx_pool());
+            tx_setup(*tx, TLM_WRITE_COMMAND, insn.data_addr, data, len);
+            tx->set_streaming_width(insn.data_len);
+            if (failed(dma.dma.send(*tx)))
                 dma.log.error("DMA channel write failed");
         }
 
@@ -11,11 +11,16 @@
 #include "vcml/models/ethernet/bridge.h"
 #include "vcml/models/ethernet/backend.h"
 #include "vcml/models/ethernet/backend_file.h"
+#include "vcml/models/ethernet/backend_pcap.h"
 
 #ifdef HAVE_TAP
 #include "vcml/models/ethernet/backend_tap.h"
 #endif
 
+#ifdef HAVE_SHM
+#include "vcml/models/ethernet/backend_shm.h"
+#endif
+
 #ifdef HAVE_LIBSLIRP
 #include "vcml/models/ethernet/backend_slirp.h"
 #endif
@@ -36,14 +41,26 @@ void backend::send_to_guest(eth_frame frame) {
     m_parent->send_to_guest(std::move(frame));
 }
 
+void backend::send_to_guest(vector<eth_frame>& frames) {
+    m_parent->send_to_guest(frames);
+}
+
+void backend::send_to_guest_at(eth_frame frame, const sc_time& t) {
+    m_parent->send_to_guest_at(std::move(frame), t);
+}
+
 backend* backend::create(bridge* br, const string& type) {
     string kind = type.substr(0, type.find(':'));
     typedef function<backend*(bridge*, const string&)> construct;
     static const unordered_map<string, construct> backends = {
         { "file", backend_file::create },
+        { "pcap", backend_pcap::create },
 #ifdef HAVE_TAP
         { "tap", backend_tap::create },
 #endif
+#ifdef HAVE_SHM
+        { "shm", backend_shm::create },
+#endif
 #ifdef HAVE_LIBSLIRP
         { "slirp", backend_slirp::create },
 #endif
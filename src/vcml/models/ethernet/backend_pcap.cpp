@@ -0,0 +1,237 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/ethernet/backend_pcap.h"
+
+namespace vcml {
+namespace ethernet {
+
+enum pcapng_block : u32 {
+    PCAPNG_SECTION_HEADER = 0x0a0d0d0a,
+    PCAPNG_INTERFACE_DESCRIPTION = 0x00000001,
+    PCAPNG_ENHANCED_PACKET = 0x00000006,
+};
+
+enum pcapng_option : u16 {
+    PCAPNG_OPT_END = 0,
+    PCAPNG_OPT_IF_NAME = 2,
+    PCAPNG_OPT_IF_TSRESOL = 9,
+    PCAPNG_OPT_EPB_FLAGS = 2,
+};
+
+enum : u32 {
+    PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d,
+    PCAPNG_LINKTYPE_ETHERNET = 1,
+    PCAPNG_TSRESOL_NS = 9,
+    PCAPNG_FLAGS_INBOUND = 1,
+    PCAPNG_FLAGS_OUTBOUND = 2,
+};
+
+template <typename T>
+static void put(vector<u8>& buf, T val) {
+    const u8* ptr = (const u8*)&val;
+    buf.insert(buf.end(), ptr, ptr + sizeof(T));
+}
+
+static void put_data(vector<u8>& buf, const u8* data, size_t len) {
+    buf.insert(buf.end(), data, data + len);
+    buf.resize(buf.size() + (-len & 3), 0);
+}
+
+static void put_option(vector<u8>& buf, u16 code, const void* data,
+                       u16 len) {
+    put<u16>(buf, code);
+    put<u16>(buf, len);
+    put_data(buf, (const u8*)data, len);
+}
+
+static size_t begin_block(vector<u8>& buf, u32 type) {
+    size_t start = buf.size();
+    put<u32>(buf, type);
+    put<u32>(buf, 0); // patched by end_block
+    return start;
+}
+
+static void end_block(vector<u8>& buf, size_t start) {
+    u32 len = buf.size() - start + sizeof(u32);
+    memcpy(buf.data() + start + sizeof(u32), &len, sizeof(len));
+    put<u32>(buf, len);
+}
+
+void backend_pcap::capture(const eth_frame& frame, bool outbound) {
+    u64 timestamp = time_to_ns(sc_time_stamp());
+
+    lock_guard<mutex> guard(m_mtx);
+    if (m_queue.size() >= QUEUE_LIMIT) {
+        m_dropped++;
+        return;
+    }
+
+    m_queue.push_back({ frame, timestamp, outbound });
+    m_captured++;
+
+    if (m_queue.size() == 1)
+        m_wake.notify_one();
+}
+
+void backend_pcap::encode_header() {
+    size_t shb = begin_block(m_buffer, PCAPNG_SECTION_HEADER);
+    put<u32>(m_buffer, PCAPNG_BYTE_ORDER_MAGIC);
+    put<u16>(m_buffer, 1); // major version
+    put<u16>(m_buffer, 0); // minor version
+    put<i64>(m_buffer, -1); // section length unknown
+    end_block(m_buffer, shb);
+
+    string name = m_parent->name();
+    u8 tsresol = PCAPNG_TSRESOL_NS;
+
+    size_t idb = begin_block(m_buffer, PCAPNG_INTERFACE_DESCRIPTION);
+    put<u16>(m_buffer, PCAPNG_LINKTYPE_ETHERNET);
+    put<u16>(m_buffer, 0); // reserved
+    put<u32>(m_buffer, 0); // no snapshot length limit
+    put_option(m_buffer, PCAPNG_OPT_IF_NAME, name.c_str(), name.length());
+    put_option(m_buffer, PCAPNG_OPT_IF_TSRESOL, &tsresol, sizeof(tsresol));
+    put_option(m_buffer, PCAPNG_OPT_END, nullptr, 0);
+    end_block(m_buffer, idb);
+}
+
+void backend_pcap::encode_packet(const record& rec) {
+    u32 len = rec.frame.size();
+    u32 flags = rec.outbound ? PCAPNG_FLAGS_OUTBOUND : PCAPNG_FLAGS_INBOUND;
+
+    size_t epb = begin_block(m_buffer, PCAPNG_ENHANCED_PACKET);
+    put<u32>(m_buffer, 0); // interface id
+    put<u32>(m_buffer, rec.timestamp >> 32);
+    put<u32>(m_buffer, rec.timestamp);
+    put<u32>(m_buffer, len); // captured length
+    put<u32>(m_buffer, len); // original length
+    put_data(m_buffer, rec.frame.data(), len);
+    put_option(m_buffer, PCAPNG_OPT_EPB_FLAGS, &flags, sizeof(flags));
+    put_option(m_buffer, PCAPNG_OPT_END, nullptr, 0);
+    end_block(m_buffer, epb);
+}
+
+void backend_pcap::flush_buffer() {
+    if (m_buffer.empty())
+        return;
+
+    m_stream.write((const char*)m_buffer.data(), m_buffer.size());
+    m_stream.flush();
+    m_buffer.clear();
+}
+
+void backend_pcap::writer() {
+    mwr::set_thread_name("vcml_pcap");
+
+    vector<record> records;
+    records.reserve(QUEUE_LIMIT);
+
+    while (true) {
+        {
+            std::unique_lock<mutex> lock(m_mtx);
+            m_wake.wait(lock, [&]() { return !m_queue.empty() || !m_running; });
+            records.swap(m_queue);
+            if (records.empty() && !m_running)
+                break;
+        }
+
+        for (const record& rec : records) {
+            encode_packet(rec);
+            if (m_buffer.size() >= BUFFER_SIZE)
+                flush_buffer();
+        }
+
+        records.clear();
+
+        // keep collecting while more frames are already waiting, so that
+        // the file is written in large blocks under high load
+        bool idle = false;
+        {
+            lock_guard<mutex> guard(m_mtx);
+            idle = m_queue.empty();
+        }
+
+        if (idle)
+            flush_buffer();
+    }
+
+    flush_buffer();
+}
+
+u64 backend_pcap::captured() {
+    lock_guard<mutex> guard(m_mtx);
+    return m_captured;
+}
+
+u64 backend_pcap::dropped() {
+    lock_guard<mutex> guard(m_mtx);
+    return m_dropped;
+}
+
+backend_pcap::backend_pcap(bridge* br, const string& filename):
+    backend(br),
+    m_filename(filename),
+    m_stream(filename, std::ios::binary | std::ios::trunc),
+    m_mtx(),
+    m_wake(),
+    m_queue(),
+    m_captured(0),
+    m_dropped(0),
+    m_running(true),
+    m_writer(),
+    m_buffer() {
+    VCML_REPORT_ON(!m_stream.good(), "failed to open file '%s'",
+                   filename.c_str());
+
+    m_type = mkstr("pcap:%s", filename.c_str());
+    m_queue.reserve(QUEUE_LIMIT);
+    m_buffer.reserve(BUFFER_SIZE + eth_frame::FRAME_MAX_SIZE + 64);
+
+    encode_header();
+    flush_buffer();
+
+    m_writer = thread(&backend_pcap::writer, this);
+}
+
+backend_pcap::~backend_pcap() {
+    {
+        lock_guard<mutex> guard(m_mtx);
+        m_running = false;
+        m_wake.notify_all();
+    }
+
+    if (m_writer.joinable())
+        m_writer.join();
+
+    if (m_dropped > 0)
+        log_warn("%s: dropped %llu frames", m_filename.c_str(),
+                 (unsigned long long)m_dropped);
+}
+
+void backend_pcap::send_to_host(const eth_frame& frame) {
+    capture(frame, true);
+}
+
+void backend_pcap::observe_to_guest(const eth_frame& frame) {
+    capture(frame, false);
+}
+
+backend* backend_pcap::create(bridge* br, const string& type) {
+    // everything after the prefix is the file name, which may hold colons
+    string file = mkstr("%s.pcapng", br->name());
+    size_t pos = type.find(':');
+    if (pos != string::npos && pos + 1 < type.length())
+        file = type.substr(pos + 1);
+
+    return new backend_pcap(br, file);
+}
+
+} // namespace ethernet
+} // namespace vcml
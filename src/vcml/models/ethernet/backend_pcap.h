@@ -0,0 +1,81 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_ETHERNET_BACKEND_PCAP_H
+#define VCML_ETHERNET_BACKEND_PCAP_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+
+#include "vcml/logging/logger.h"
+
+#include "vcml/models/ethernet/backend.h"
+#include "vcml/models/ethernet/bridge.h"
+
+namespace vcml {
+namespace ethernet {
+
+// Captures the traffic of a bridge in both directions into a pcapng file
+// using simulated timestamps at nanosecond resolution. Frames are only
+// queued on the simulation side. A background thread encodes them and
+// writes the file in large blocks. Frames sent by the guest are marked as
+// outbound, frames delivered to the guest as inbound.
+class backend_pcap : public backend
+{
+public:
+    enum : size_t {
+        BUFFER_SIZE = 1 * MiB,
+        QUEUE_LIMIT = 64 * KiB,
+    };
+
+private:
+    struct record {
+        eth_frame frame;
+        u64 timestamp;
+        bool outbound;
+    };
+
+    string m_filename;
+    ofstream m_stream;
+
+    mutex m_mtx;
+    condition_variable m_wake;
+    vector<record> m_queue;
+    u64 m_captured;
+    u64 m_dropped;
+    bool m_running;
+    thread m_writer;
+
+    vector<u8> m_buffer;
+
+    void capture(const eth_frame& frame, bool outbound);
+
+    void encode_header();
+    void encode_packet(const record& rec);
+    void flush_buffer();
+    void writer();
+
+public:
+    u64 captured();
+    u64 dropped();
+
+    backend_pcap(bridge* br, const string& filename);
+    virtual ~backend_pcap();
+
+    virtual void send_to_host(const eth_frame& frame) override;
+    virtual void observe_to_guest(const eth_frame& frame) override;
+
+    static backend* create(bridge* br, const string& type);
+};
+
+} // namespace ethernet
+} // namespace vcml
+
+#endif
@@ -0,0 +1,433 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include "vcml/models/ethernet/backend_shm.h"
+
+namespace vcml {
+namespace ethernet {
+
+enum : u32 {
+    SHM_MAGIC = 0x4d485356, // "VSHM"
+    SHM_VERSION = 1,
+};
+
+struct backend_shm::ring {
+    struct slot {
+        u32 length;
+        u32 reserved;
+        u64 timestamp;
+        u8 data[SLOT_SIZE];
+    };
+
+    alignas(64) atomic<u64> head;
+    alignas(64) atomic<u64> tail;
+    slot slots[RING_SLOTS];
+};
+
+struct backend_shm::layout {
+    u32 magic;
+    u32 version;
+    ring rings[2];
+};
+
+static_assert(atomic<u64>::is_always_lock_free,
+              "shared memory rings require lock-free atomics");
+static_assert((size_t)backend_shm::SLOT_SIZE >= eth_frame::FRAME_MAX_SIZE,
+              "shared memory ring slots too small");
+
+static socklen_t socket_address(const string& name, sockaddr_un& addr) {
+    string path = "vcml-eth-" + name;
+    VCML_REPORT_ON(path.length() + 1 > sizeof(addr.sun_path),
+                   "shm name too long: %s", name.c_str());
+
+    // use the abstract namespace, so that sockets vanish with their process
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path + 1, path.c_str(), path.length());
+    return offsetof(sockaddr_un, sun_path) + 1 + path.length();
+}
+
+static bool send_fd(int sock, int fd) {
+    char dummy = 0;
+    iovec iov = { &dummy, sizeof(dummy) };
+
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+
+    memset(&ctrl, 0, sizeof(ctrl));
+
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    return n == sizeof(dummy);
+}
+
+static int recv_fd(int sock) {
+    char dummy = 0;
+    iovec iov = { &dummy, sizeof(dummy) };
+
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } ctrl;
+
+    msghdr msg = {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+
+    ssize_t n;
+    do {
+        n = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    } while (n < 0 && errno == EINTR);
+
+    if (n != sizeof(dummy))
+        return -1;
+
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET ||
+        cmsg->cmsg_type != SCM_RIGHTS) {
+        return -1;
+    }
+
+    int fd = -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    return fd;
+}
+
+void backend_shm::fail(const char* what) {
+    int err = errno;
+    close_shm();
+    VCML_REPORT("shm:%s: %s: %s", m_name.c_str(), what, strerror(err));
+}
+
+void backend_shm::map_shm(bool create) {
+    string path = "/vcml-eth-" + m_name;
+    int flags = O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0);
+    int fd = shm_open(path.c_str(), flags, 0600);
+    if (fd < 0)
+        fail("cannot open shared memory");
+
+    if (create && ftruncate(fd, sizeof(layout)) < 0) {
+        close(fd);
+        fail("cannot resize shared memory");
+    }
+
+    void* ptr = mmap(nullptr, sizeof(layout), PROT_READ | PROT_WRITE,
+                     MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        fail("cannot map shared memory");
+
+    m_shm = (layout*)ptr;
+    m_tx = &m_shm->rings[m_server ? 0 : 1];
+    m_rx = &m_shm->rings[m_server ? 1 : 0];
+
+    if (create) {
+        for (ring& r : m_shm->rings) {
+            r.head.store(0);
+            r.tail.store(0);
+        }
+
+        m_shm->version = SHM_VERSION;
+        m_shm->magic = SHM_MAGIC;
+    } else if (m_shm->magic != SHM_MAGIC || m_shm->version != SHM_VERSION) {
+        close_shm();
+        VCML_REPORT("shm:%s: incompatible shared memory", m_name.c_str());
+    }
+}
+
+void backend_shm::accept_peer() {
+    int fd = accept4(m_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    // the old peer may have left without us having noticed yet
+    if (m_sock_fd >= 0 && peer_gone())
+        disconnect();
+
+    if (m_sock_fd >= 0) {
+        log_warn("shm:%s: rejecting additional peer", m_name.c_str());
+        close(fd);
+        return;
+    }
+
+    m_sock_fd = fd;
+    if (!exchange_doorbells()) {
+        log_error("shm:%s: failed to connect peer", m_name.c_str());
+        disconnect();
+    }
+}
+
+bool backend_shm::exchange_doorbells() {
+    if (!send_fd(m_sock_fd, m_rx_fd))
+        return false;
+
+    int peer = recv_fd(m_sock_fd);
+    if (peer < 0)
+        return false;
+
+    mwr::aio_notify(m_rx_fd, [this](int) -> void { receive(); });
+    mwr::aio_notify(m_sock_fd, [this](int) -> void { hangup(); });
+    m_peer_fd = peer;
+    log_info("shm:%s: connected to peer", m_name.c_str());
+
+    // the peer may have queued frames while we were connecting
+    kick(peer);
+    return true;
+}
+
+bool backend_shm::peer_gone() {
+    // peers never send anything after the handshake, so the socket only
+    // becomes readable once the other side has closed it
+    char dummy;
+    ssize_t n = recv(m_sock_fd, &dummy, sizeof(dummy),
+                     MSG_PEEK | MSG_DONTWAIT);
+    if (n > 0)
+        return false;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return false;
+    return true;
+}
+
+void backend_shm::hangup() {
+    if (m_sock_fd >= 0 && peer_gone())
+        disconnect();
+}
+
+void backend_shm::disconnect() {
+    mwr::aio_cancel(m_rx_fd);
+    mwr::aio_cancel(m_sock_fd);
+    close(m_sock_fd);
+    m_sock_fd = -1;
+
+    // send_to_host may be halfway through producing a frame, so wait for
+    // it before closing its doorbell and resetting the rings beneath it
+    lock_guard<mutex> guard(m_tx_mtx);
+    int peer = m_peer_fd.exchange(-1);
+    if (peer >= 0)
+        close(peer);
+
+    // a new peer starts with empty rings, anything still queued is lost
+    for (ring& r : m_shm->rings) {
+        r.head.store(0);
+        r.tail.store(0);
+    }
+
+    log_info("shm:%s: peer disconnected", m_name.c_str());
+}
+
+void backend_shm::receive() {
+    u64 count = 0;
+    while (read(m_rx_fd, &count, sizeof(count)) < 0 && errno == EINTR) {
+        // retry
+    }
+
+    u64 tail = m_rx->tail.load(std::memory_order_relaxed);
+    while (true) {
+        u64 head = m_rx->head.load(std::memory_order_acquire);
+        if (tail == head) {
+            // pairs with send_to_host: either we see the new head here or
+            // the producer sees our tail and rings the doorbell
+            m_rx->tail.store(tail, std::memory_order_seq_cst);
+            if (m_rx->head.load(std::memory_order_seq_cst) == tail)
+                break;
+            continue;
+        }
+
+        const ring::slot& slot = m_rx->slots[tail % RING_SLOTS];
+        if (slot.length <= eth_frame::FRAME_MAX_SIZE) {
+            eth_frame frame(slot.data, slot.length);
+            if (m_timed) {
+                sc_time t = time_from_value(slot.timestamp * m_ns);
+                send_to_guest_at(std::move(frame), t);
+            } else {
+                m_batch.push_back(std::move(frame));
+                if (m_batch.size() >= RING_SLOTS)
+                    send_to_guest(m_batch);
+            }
+        }
+
+        m_rx->tail.store(++tail, std::memory_order_release);
+    }
+
+    send_to_guest(m_batch);
+}
+
+void backend_shm::kick(int peer) {
+    u64 one = 1;
+    ssize_t n;
+    do {
+        n = write(peer, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+}
+
+void backend_shm::close_shm() {
+    if (m_rx_fd >= 0)
+        mwr::aio_cancel(m_rx_fd);
+    if (m_sock_fd >= 0)
+        mwr::aio_cancel(m_sock_fd);
+    if (m_listen_fd >= 0)
+        mwr::aio_cancel(m_listen_fd);
+
+    for (int* fd : { &m_listen_fd, &m_sock_fd, &m_rx_fd }) {
+        if (*fd >= 0)
+            close(*fd);
+        *fd = -1;
+    }
+
+    {
+        lock_guard<mutex> guard(m_tx_mtx);
+        int peer = m_peer_fd.exchange(-1);
+        if (peer >= 0)
+            close(peer);
+    }
+
+    if (m_shm != nullptr) {
+        munmap(m_shm, sizeof(layout));
+        m_shm = nullptr;
+        m_tx = m_rx = nullptr;
+    }
+
+    if (m_server) {
+        string path = "/vcml-eth-" + m_name;
+        shm_unlink(path.c_str());
+        m_server = false;
+    }
+}
+
+backend_shm::backend_shm(bridge* br, const string& name, bool timed):
+    backend(br),
+    m_name(name),
+    m_timed(timed),
+    m_server(false),
+    m_ns(sc_time(1.0, SC_NS).value()),
+    m_listen_fd(-1),
+    m_sock_fd(-1),
+    m_rx_fd(-1),
+    m_peer_fd(-1),
+    m_tx_mtx(),
+    m_shm(nullptr),
+    m_tx(nullptr),
+    m_rx(nullptr),
+    m_batch(),
+    m_dropped(0) {
+    m_type = mkstr("shm:%s%s", name.c_str(), timed ? ":timed" : "");
+    m_batch.reserve(RING_SLOTS);
+
+    sockaddr_un addr;
+    socklen_t len = socket_address(name, addr);
+
+    m_rx_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_rx_fd < 0)
+        fail("cannot create doorbell");
+
+    m_listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (m_listen_fd < 0)
+        fail("cannot create socket");
+
+    if (bind(m_listen_fd, (sockaddr*)&addr, len) == 0) {
+        m_server = true;
+        map_shm(true);
+
+        if (listen(m_listen_fd, 1) < 0)
+            fail("cannot listen on socket");
+
+        mwr::aio_notify(m_listen_fd, [this](int) -> void { accept_peer(); });
+        log_info("shm:%s: waiting for peer", name.c_str());
+        return;
+    }
+
+    if (errno != EADDRINUSE)
+        fail("cannot bind socket");
+
+    // somebody else is already listening, so we become the client
+    m_sock_fd = m_listen_fd;
+    m_listen_fd = -1;
+
+    if (connect(m_sock_fd, (sockaddr*)&addr, len) < 0)
+        fail("cannot connect to peer");
+
+    map_shm(false);
+
+    if (!exchange_doorbells())
+        fail("cannot exchange doorbells");
+}
+
+backend_shm::~backend_shm() {
+    close_shm();
+
+    if (m_dropped > 0)
+        log_warn("shm:%s: dropped %llu frames", m_name.c_str(),
+                 (unsigned long long)m_dropped);
+}
+
+void backend_shm::send_to_host(const eth_frame& frame) {
+    lock_guard<mutex> guard(m_tx_mtx);
+    int peer = m_peer_fd;
+    if (peer < 0 || frame.size() > SLOT_SIZE) {
+        m_dropped++;
+        return;
+    }
+
+    u64 head = m_tx->head.load(std::memory_order_relaxed);
+    u64 tail = m_tx->tail.load(std::memory_order_acquire);
+    if (head - tail >= RING_SLOTS) {
+        m_dropped++;
+        return;
+    }
+
+    ring::slot& slot = m_tx->slots[head % RING_SLOTS];
+    slot.length = frame.size();
+    slot.timestamp = time_stamp_ns();
+    memcpy(slot.data, frame.data(), frame.size());
+
+    // only ring the doorbell if the peer had already drained everything
+    // before this frame, otherwise it is still busy receiving
+    m_tx->head.store(head + 1, std::memory_order_seq_cst);
+    if (m_tx->tail.load(std::memory_order_seq_cst) == head)
+        kick(peer);
+}
+
+backend* backend_shm::create(bridge* br, const string& type) {
+    vector<string> args = split(type, ':');
+    string name = args.size() > 1 ? args[1] : string(br->name());
+    bool timed = args.size() > 2 && args[2] == "timed";
+    return new backend_shm(br, name, timed);
+}
+
+} // namespace ethernet
+} // namespace vcml
@@ -0,0 +1,98 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VCML_ETHERNET_BACKEND_SHM_H
+#define VCML_ETHERNET_BACKEND_SHM_H
+
+#include "vcml/core/types.h"
+#include "vcml/core/systemc.h"
+
+#include "vcml/logging/logger.h"
+
+#include "vcml/models/ethernet/backend.h"
+#include "vcml/models/ethernet/bridge.h"
+
+namespace vcml {
+namespace ethernet {
+
+// Connects two bridges, usually in different simulator processes, that use
+// the same name with "shm:<name>". Frames travel through a pair of lock-free
+// single-producer/single-consumer rings in POSIX shared memory. Each side
+// owns an eventfd doorbell that its peer receives over a Unix socket and
+// rings whenever the receiving ring was drained. The first process to
+// appear creates the memory and listens on the socket. The second one
+// connects. With "shm:<name>:timed", frames carry the sender's simulation
+// time and are not delivered to the guest before the receiver reaches it.
+// The two simulations are not synchronized, so a frame that arrives after
+// the receiver has already passed its time is delivered at once and counted
+// by the bridge as late. Causal order only holds while the receiver runs
+// behind its sender. When the peer hangs up, the server resets the rings
+// and accepts the next peer.
+class backend_shm : public backend
+{
+public:
+    enum : size_t {
+        RING_SLOTS = 256,
+        SLOT_SIZE = 1536,
+    };
+
+private:
+    struct layout;
+    struct ring;
+
+    string m_name;
+    bool m_timed;
+    bool m_server;
+    u64 m_ns;
+
+    int m_listen_fd;
+    int m_sock_fd;
+    int m_rx_fd;
+    atomic<int> m_peer_fd;
+
+    // serializes producing into m_tx against the peer going away
+    mutex m_tx_mtx;
+
+    layout* m_shm;
+    ring* m_tx;
+    ring* m_rx;
+
+    vector<eth_frame> m_batch;
+    atomic<u64> m_dropped;
+
+    void fail(const char* what);
+    void map_shm(bool create);
+    void accept_peer();
+    bool exchange_doorbells();
+    bool peer_gone();
+    void hangup();
+    void disconnect();
+    void receive();
+    void kick(int peer);
+    void close_shm();
+
+public:
+    const char* shm_name() const { return m_name.c_str(); }
+    bool is_timed() const { return m_timed; }
+    bool is_connected() const { return m_peer_fd >= 0; }
+    u64 dropped() const { return m_dropped; }
+
+    backend_shm(bridge* br, const string& name, bool timed);
+    virtual ~backend_shm();
+
+    virtual void send_to_host(const eth_frame& frame) override;
+
+    static backend* create(bridge* br, const string& type);
+};
+
+} // namespace ethernet
+} // namespace vcml
+
+#endif
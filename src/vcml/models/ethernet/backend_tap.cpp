@@ -17,76 +17,160 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 
 #include "vcml/models/ethernet/backend_tap.h"
 
 namespace vcml {
 namespace ethernet {
 
-static bool tap_read(int fd, vector<u8>& buf) {
-    size_t len;
-    buf.resize(eth_frame::FRAME_MAX_SIZE);
+static ssize_t tap_read(int fd, eth_frame& frame) {
+    ssize_t len;
+    frame.resize(eth_frame::FRAME_MAX_SIZE);
 
     do {
-        len = read(fd, buf.data(), buf.size());
+        len = read(fd, frame.mutable_data(), frame.size());
     } while (len < 0 && errno == EINTR);
 
-    if (len < 0)
-        return false;
+    if (len >= 0)
+        frame.resize(len);
 
-    buf.resize(len);
-    return true;
+    return len;
+}
+
+static ssize_t tap_write(int fd, const eth_frame& frame) {
+    ssize_t len;
+
+    do {
+        len = write(fd, frame.data(), frame.size());
+    } while (len < 0 && errno == EINTR);
+
+    return len;
+}
+
+static bool tap_writable(int fd, int timeout_ms) {
+    pollfd pfd = { fd, POLLOUT, 0 };
+    int res;
+
+    do {
+        res = poll(&pfd, 1, timeout_ms);
+    } while (res < 0 && errno == EINTR);
+
+    return res > 0;
+}
+
+void backend_tap::receive(size_t queue) {
+    int fd = m_fds[queue];
+    vector<eth_frame>& batch = m_batches[queue];
+
+    while (true) {
+        eth_frame frame;
+        ssize_t len = tap_read(fd, frame);
+        if (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+            log_error("error reading tap device: %s", strerror(errno));
+            mwr::aio_cancel(fd);
+            break;
+        }
+
+        if (len <= 0)
+            break;
+
+        batch.push_back(std::move(frame));
+        if (batch.size() >= BATCH_SIZE)
+            send_to_guest(batch);
+    }
+
+    send_to_guest(batch);
 }
 
 void backend_tap::close_tap() {
-    if (m_fd >= 0) {
-        mwr::aio_cancel(m_fd);
-        close(m_fd);
-        m_fd = -1;
+    for (int fd : m_fds) {
+        mwr::aio_cancel(fd);
+        close(fd);
     }
+
+    m_fds.clear();
 }
 
-backend_tap::backend_tap(bridge* br, int devno): backend(br) {
-    m_fd = open("/dev/net/tun", O_RDWR);
-    VCML_REPORT_ON(m_fd < 0, "error opening tundev: %s", strerror(errno));
+backend_tap::backend_tap(bridge* br, int devno, size_t queues):
+    backend(br), m_fds(), m_batches(queues), m_dropped(0) {
+    VCML_REPORT_ON(queues == 0, "tap device needs at least one queue");
 
     struct ifreq ifr;
     memset(&ifr, 0, sizeof(ifr));
     ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    if (queues > 1)
+        ifr.ifr_flags |= IFF_MULTI_QUEUE;
     snprintf(ifr.ifr_name, IFNAMSIZ, "tap%d", devno);
 
-    int err = ioctl(m_fd, TUNSETIFF, (void*)&ifr);
-    VCML_REPORT_ON(err < 0, "error creating tapdev: %s", strerror(errno));
-    log_info("using tap device %s", ifr.ifr_name);
-
-    m_type = mkstr("tap:%d", devno);
+    for (size_t i = 0; i < queues; i++) {
+        int fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+        if (fd < 0) {
+            close_tap();
+            VCML_REPORT("error opening tundev: %s", strerror(errno));
+        }
 
-    mwr::aio_notify(m_fd, [&](int fd) -> void {
-        eth_frame frame;
-        if (!tap_read(fd, frame)) {
-            log_error("error reading tap device: %s", strerror(errno));
-            mwr::aio_cancel(fd);
-            return;
+        m_fds.push_back(fd);
+        if (ioctl(fd, TUNSETIFF, (void*)&ifr) < 0) {
+            close_tap();
+            VCML_REPORT("error creating tapdev: %s", strerror(errno));
         }
 
-        send_to_guest(std::move(frame));
-    });
+        m_batches[i].reserve(BATCH_SIZE);
+    }
+
+    if (queues > 1) {
+        log_info("using tap device %s with %zu queues", ifr.ifr_name, queues);
+        m_type = mkstr("tap:%d:%zu", devno, queues);
+    } else {
+        log_info("using tap device %s", ifr.ifr_name);
+        m_type = mkstr("tap:%d", devno);
+    }
+
+    for (size_t i = 0; i < queues; i++)
+        mwr::aio_notify(m_fds[i], [this, i](int) -> void { receive(i); });
 }
 
 backend_tap::~backend_tap() {
     close_tap();
+
+    if (m_dropped > 0)
+        log_warn("dropped %llu frames", (unsigned long long)m_dropped);
 }
 
 void backend_tap::send_to_host(const eth_frame& frame) {
-    if (m_fd >= 0)
-        mwr::fd_write(m_fd, frame.data(), frame.size());
+    if (m_fds.empty())
+        return;
+
+    size_t queue = 0;
+    if (m_fds.size() > 1 && frame.size() >= eth_frame::FRAME_HEADER_SIZE) {
+        u64 flow = (u64)frame.source() ^ (u64)frame.destination();
+        queue = flow % m_fds.size();
+    }
+
+    // the fds are non-blocking for the receive side, so wait for the
+    // kernel to make room instead of dropping frames under load
+    int fd = m_fds[queue];
+    ssize_t len = tap_write(fd, frame);
+    while (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+           tap_writable(fd, TX_TIMEOUT_MS)) {
+        len = tap_write(fd, frame);
+    }
+
+    if (len < 0) {
+        if (m_dropped++ == 0)
+            log_warn("dropping frames, tap device: %s", strerror(errno));
+        else
+            log_debug("error writing tap device: %s", strerror(errno));
+    }
 }
 
 backend* backend_tap::create(bridge* br, const string& type) {
     unsigned int devno = 0;
-    if (sscanf(type.c_str(), "tap:%u", &devno) != 1)
+    unsigned int queues = 1;
+    if (sscanf(type.c_str(), "tap:%u:%u", &devno, &queues) < 1)
         devno = 0;
-    return new backend_tap(br, devno);
+    return new backend_tap(br, devno, queues);
 }
 
 } // namespace ethernet
@@ -20,15 +20,33 @@
 namespace vcml {
 namespace ethernet {
 
+// Frames are read in batches: every wakeup drains all frames currently
+// pending on a queue and hands them to the bridge at once. Creating the
+// backend as "tap:<devno>:<queues>" opens a multi-queue tap device, where
+// the kernel spreads receive flows across queues and transmit queues are
+// chosen by a hash of the frame addresses. Sending waits up to
+// TX_TIMEOUT_MS for room on a full queue before a frame gets dropped.
 class backend_tap : public backend
 {
+public:
+    enum : size_t {
+        BATCH_SIZE = 64,
+        TX_TIMEOUT_MS = 100,
+    };
+
 private:
-    int m_fd;
+    vector<int> m_fds;
+    vector<vector<eth_frame>> m_batches;
+    u64 m_dropped;
 
+    void receive(size_t queue);
     void close_tap();
 
 public:
-    backend_tap(bridge* br, int devno);
+    size_t num_queues() const { return m_fds.size(); }
+    u64 dropped() const { return m_dropped; }
+
+    backend_tap(bridge* br, int devno, size_t queues = 1);
     virtual ~backend_tap();
 
     virtual void send_to_host(const eth_frame& frame) override;
@@ -65,15 +65,51 @@ void bridge::eth_receive(const eth_frame& frame) {
 }
 
 void bridge::eth_transmit() {
+    vector<eth_frame> frames;
     while (true) {
-        wait(m_ev);
+        sc_time next = SC_ZERO_TIME;
+        sc_time now = sc_time_stamp();
+        size_t late = 0;
 
-        lock_guard<mutex> guard(m_mtx);
-        while (!m_rx.empty()) {
-            eth_frame frame = std::move(m_rx.front());
-            m_rx.pop();
+        {
+            lock_guard<mutex> guard(m_mtx);
+            frames.swap(m_rx);
+
+            auto it = m_timed.begin();
+            for (; it != m_timed.end() && it->first <= now; it++) {
+                if (it->first < now)
+                    late++;
+                frames.push_back(std::move(it->second));
+            }
+
+            m_timed.erase(m_timed.begin(), it);
+
+            if (!m_timed.empty())
+                next = m_timed.begin()->first - now;
+        }
+
+        // timed frames stamped before now arrived after we had already
+        // passed their time, they can only be delivered right away
+        if (late > 0) {
+            if (m_late == 0)
+                log_warn("timed frames arrive late, their sender runs behind");
+            log_debug("delivering %zu timed frames late at %s", late,
+                      now.to_string().c_str());
+            m_late += late;
+        }
+
+        for (const eth_frame& frame : frames) {
             eth_tx.send(frame);
+            for (backend* b : m_backends)
+                b->observe_to_guest(frame);
         }
+
+        frames.clear();
+
+        if (next > SC_ZERO_TIME)
+            wait(next, m_ev);
+        else
+            wait(m_ev);
     }
 }
 
@@ -90,7 +126,9 @@ bridge::bridge(const sc_module_name& nm):
     m_backends(),
     m_mtx(),
     m_rx(),
+    m_timed(),
     m_ev("rxev"),
+    m_late(0),
     backends("backends", ""),
     eth_tx("eth_tx"),
     eth_rx("eth_rx") {
@@ -122,6 +160,10 @@ bridge::~bridge() {
     for (auto it : m_dynamic_backends)
         delete it.second;
 
+    if (m_late > 0)
+        log_warn("delivered %llu timed frames late",
+                 (unsigned long long)m_late);
+
     bridges().erase(name());
 }
 
@@ -132,8 +174,32 @@ void bridge::send_to_host(const eth_frame& frame) {
 
 void bridge::send_to_guest(eth_frame frame) {
     lock_guard<mutex> guard(m_mtx);
-    m_rx.push(std::move(frame));
-    on_next_update([&]() -> void { m_ev.notify(SC_ZERO_TIME); });
+    m_rx.push_back(std::move(frame));
+    if (m_rx.size() == 1)
+        on_next_update([&]() -> void { m_ev.notify(SC_ZERO_TIME); });
+}
+
+void bridge::send_to_guest(vector<eth_frame>& frames) {
+    if (frames.empty())
+        return;
+
+    lock_guard<mutex> guard(m_mtx);
+    bool idle = m_rx.empty();
+    for (eth_frame& frame : frames)
+        m_rx.push_back(std::move(frame));
+    frames.clear();
+
+    // the transmit thread drains the whole queue, so an update only needs
+    // to be scheduled when the queue was empty before
+    if (idle)
+        on_next_update([&]() -> void { m_ev.notify(SC_ZERO_TIME); });
+}
+
+void bridge::send_to_guest_at(eth_frame frame, const sc_time& t) {
+    lock_guard<mutex> guard(m_mtx);
+    auto it = m_timed.emplace(t, std::move(frame));
+    if (it == m_timed.begin())
+        on_next_update([&]() -> void { m_ev.notify(SC_ZERO_TIME); });
 }
 
 void bridge::attach(backend* b) {
@@ -206,8 +206,8 @@ bool ethoc::tx_packet(u32 addr, u32 length) {
         return false;
     }
 
-    vector<u8> buffer(length);
-    tlm_response_status rs = out.read(addr, buffer.data(), buffer.size());
+    eth_frame buffer(length);
+    tlm_response_status rs = out.read(addr, buffer.mutable_data(), length);
     if (failed(rs)) {
         log_warn("tx error  %s while reading from 0x%08x",
                  tlm_response_to_str(rs), addr);
@@ -221,6 +221,9 @@ bool ethoc::tx_packet(u32 addr, u32 length) {
     }
 
     log_debug("sending packet:\n%s", ss.str().c_str());
+
+    if (buffer.size() < eth_frame::FRAME_MIN_SIZE)
+        buffer.resize(eth_frame::FRAME_MIN_SIZE);
     eth_tx.send(buffer);
 
     return true;
@@ -13,17 +13,168 @@
 namespace vcml {
 namespace ethernet {
 
-void network::eth_receive(const eth_target_socket& rx, const eth_frame& fr) {
-    const eth_initiator_socket& sender = peer_of(rx);
+static u64 fdb_key(u16 vlan, const mac_addr& mac) {
+    return (u64)vlan << 48 | (u64)mac;
+}
+
+u16 network::vlan_of(const eth_frame& frame) const {
+    if (!vlan_aware || frame.size() < eth_frame::FRAME_HEADER_SIZE + 4)
+        return 0;
+    if (bswap(frame.read<u16>(12)) != eth_frame::ETHER_TYPE_VLAN)
+        return 0;
+    return bswap(frame.read<u16>(14)) & 0xfff;
+}
+
+bool network::expired(const fdb_entry& entry) const {
+    return aging.get() > SC_ZERO_TIME && sc_time_stamp() - entry.seen >= aging;
+}
+
+void network::learn(size_t port, u16 vlan, const mac_addr& mac) {
+    auto it = m_fdb.find(fdb_key(vlan, mac));
+    if (it != m_fdb.end()) {
+        it->second.port = port;
+        it->second.seen = sc_time_stamp();
+        return;
+    }
+
+    if (aging.get() > SC_ZERO_TIME && sc_time_stamp() - m_last_aging >= aging)
+        age();
+
+    m_fdb[fdb_key(vlan, mac)] = { mac, vlan, port, sc_time_stamp() };
+}
+
+bool network::lookup(u16 vlan, const mac_addr& mac, size_t& port) {
+    auto it = m_fdb.find(fdb_key(vlan, mac));
+    if (it == m_fdb.end())
+        return false;
+
+    if (expired(it->second)) {
+        m_fdb.erase(it);
+        return false;
+    }
+
+    port = it->second.port;
+    return true;
+}
+
+void network::age() {
+    for (auto it = m_fdb.begin(); it != m_fdb.end();) {
+        if (expired(it->second))
+            it = m_fdb.erase(it);
+        else
+            it++;
+    }
+
+    m_last_aging = sc_time_stamp();
+}
+
+void network::forward(size_t port, const eth_frame& frame) {
+    if (!eth_tx.exists(port))
+        return;
+
+    port_stats& stats = m_stats[port];
+    stats.tx_frames++;
+    stats.tx_bytes += frame.size();
+    eth_tx[port].send(frame);
+}
+
+void network::flood(size_t port, const eth_frame& frame) {
+    m_stats[port].num_flooded++;
     for (auto& tx : eth_tx) {
-        if (tx.second != &sender)
-            tx.second->send(fr);
+        if (tx.first != port)
+            forward(tx.first, frame);
+    }
+}
+
+bool network::cmd_show_fdb(const vector<string>& args, ostream& os) {
+    age();
+
+    vector<const fdb_entry*> entries;
+    for (const auto& it : m_fdb)
+        entries.push_back(&it.second);
+
+    std::sort(entries.begin(), entries.end(),
+              [](const fdb_entry* a, const fdb_entry* b) {
+                  return fdb_key(a->vlan, a->mac) < fdb_key(b->vlan, b->mac);
+              });
+
+    os << "learning " << (learning ? "enabled" : "disabled") << ", "
+       << entries.size() << " entries";
+
+    for (const fdb_entry* entry : entries) {
+        os << std::endl << "  " << entry->mac;
+        if (vlan_aware)
+            os << " vlan " << entry->vlan;
+        os << " port " << entry->port << " age "
+           << (sc_time_stamp() - entry->seen);
+    }
+
+    vector<size_t> ports;
+    for (const auto& it : eth_rx)
+        ports.push_back(it.first);
+    std::sort(ports.begin(), ports.end());
+
+    for (size_t port : ports) {
+        port_stats stats = get_stats(port);
+        os << std::endl
+           << "port " << port << ": rx " << stats.rx_frames << " frames ("
+           << stats.rx_bytes << " bytes), tx " << stats.tx_frames
+           << " frames (" << stats.tx_bytes << " bytes), flooded "
+           << stats.num_flooded << ", filtered " << stats.num_filtered;
     }
+
+    return true;
+}
+
+void network::eth_receive(const eth_target_socket& rx, const eth_frame& fr) {
+    size_t port = eth_rx.index_of(rx);
+    port_stats& stats = m_stats[port];
+    stats.rx_frames++;
+    stats.rx_bytes += fr.size();
+
+    if (!learning || fr.size() < eth_frame::FRAME_HEADER_SIZE) {
+        flood(port, fr);
+        return;
+    }
+
+    u16 vlan = vlan_of(fr);
+    mac_addr src = fr.source();
+    if (src.is_unicast())
+        learn(port, vlan, src);
+
+    size_t dest = 0;
+    if (!fr.is_unicast() || !lookup(vlan, fr.destination(), dest)) {
+        flood(port, fr);
+        return;
+    }
+
+    if (dest == port)
+        stats.num_filtered++;
+    else
+        forward(dest, fr);
+}
+
+network::port_stats network::get_stats(size_t port) const {
+    auto it = m_stats.find(port);
+    if (it == m_stats.end())
+        return port_stats();
+    return it->second;
 }
 
 network::network(const sc_module_name& nm):
-    module(nm), eth_host(), m_next_id(0), eth_tx("eth_tx"), eth_rx("eth_rx") {
-    // nothing to do
+    module(nm),
+    eth_host(),
+    m_next_id(0),
+    m_last_aging(),
+    m_fdb(),
+    m_stats(),
+    learning("learning", false),
+    vlan_aware("vlan_aware", false),
+    aging("aging", sc_time(300, SC_SEC)),
+    eth_tx("eth_tx"),
+    eth_rx("eth_rx") {
+    register_command("show_fdb", 0, &network::cmd_show_fdb,
+                     "shows learned addresses and per-port statistics");
 }
 
 void network::bind(eth_initiator_socket& tx, eth_target_socket& rx) {
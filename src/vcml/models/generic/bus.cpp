@@ -74,20 +74,52 @@ bool bus::cmd_mmap(const vector<string>& args, ostream& os) {
     return true;
 }
 
-const bus::mapping& bus::lookup(tlm_target_socket& s, const range& mem) const {
-    size_t port = in.index_of(s);
+const bus::mapping* bus::decode(const vector<const mapping*>& table,
+                                const range& mem) {
+    auto it = std::upper_bound(table.begin(), table.end(), mem.start,
+                               [](u64 addr, const mapping* m) -> bool {
+                                   return addr < m->addr.start;
+                               });
+
+    if (it == table.begin())
+        return nullptr;
+
+    const mapping* m = *(--it);
+    return m->addr.includes(mem) ? m : nullptr;
+}
 
+void bus::update_decoders() {
+    size_t nsources = 0;
     for (const auto& m : m_mappings) {
-        if (m.addr.includes(mem) && m.source == port)
-            return m;
+        if (m.source != SOURCE_ANY)
+            nsources = max(nsources, m.source + 1);
     }
 
+    m_shared.clear();
+    m_decoders.clear();
+    m_decoders.resize(nsources);
+
+    // mappings of one source never overlap and m_mappings is already
+    // ordered by start address, so every table ends up sorted
     for (const auto& m : m_mappings) {
-        if (m.addr.includes(mem) && m.source == SOURCE_ANY)
-            return m;
+        if (m.source == SOURCE_ANY)
+            m_shared.push_back(&m);
+        else
+            m_decoders[m.source].push_back(&m);
     }
+}
 
-    return m_default;
+const bus::mapping& bus::lookup(tlm_target_socket& s,
+                                const range& mem) const {
+    size_t port = in.index_of(s);
+    if (port < m_decoders.size()) {
+        const mapping* m = decode(m_decoders[port], mem);
+        if (m != nullptr)
+            return *m;
+    }
+
+    const mapping* m = decode(m_shared, mem);
+    return m ? *m : m_default;
 }
 
 void bus::handle_bus_error(tlm_generic_payload& tx) const {
@@ -124,6 +156,10 @@ void bus::map(size_t target, const range& addr, u64 offset, size_t source) {
     m.addr = addr;
     m.offset = offset;
     m_mappings.insert(m);
+
+    // rebuild here rather than in lookup, which async processors may call
+    // concurrently from their worker threads and must stay read-only
+    update_decoders();
 }
 
 void bus::map_default(size_t target, u64 offset) {
@@ -234,6 +270,8 @@ bus::bus(const sc_module_name& nm):
     component(nm),
     m_mappings(),
     m_default(),
+    m_decoders(),
+    m_shared(),
     lenient("lenient", false),
     in("in"),
     out("out") {
@@ -0,0 +1,127 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/models/meta/quantum.h"
+
+namespace vcml {
+namespace meta {
+
+void adaptive_quantum::set_quantum(const sc_time& quantum) {
+    account();
+    tlm::tlm_global_quantum::instance().set(quantum);
+    log_debug("quantum set to %s", quantum.to_string().c_str());
+}
+
+void adaptive_quantum::account() {
+    sc_time now = sc_time_stamp();
+    if (now > m_last)
+        m_histogram[current_quantum()] += now - m_last;
+    m_last = now;
+}
+
+void adaptive_quantum::update() {
+    next_trigger(update_interval);
+
+    u64 count = interaction_count();
+    u64 events = count - m_interactions;
+    m_interactions = count;
+
+    sc_time quantum = current_quantum();
+    if (events >= shrink_threshold) {
+        m_quiet = 0;
+        if (quantum > min_quantum) {
+            set_quantum(max<sc_time>(min_quantum, quantum * shrink_factor));
+            m_num_shrink++;
+        }
+    } else if (events <= grow_threshold) {
+        if (++m_quiet >= hysteresis && quantum < max_quantum) {
+            m_quiet = 0;
+            set_quantum(min<sc_time>(max_quantum, quantum * grow_factor));
+            m_num_grow++;
+        }
+    } else {
+        m_quiet = 0;
+    }
+}
+
+bool adaptive_quantum::cmd_show_stats(const vector<string>& args,
+                                      ostream& os) {
+    os << "current quantum: " << current_quantum() << std::endl
+       << "quantum increases: " << m_num_grow << std::endl
+       << "quantum decreases: " << m_num_shrink << std::endl
+       << "time spent per quantum:";
+
+    sc_time total = sc_time_stamp();
+    for (const auto& [quantum, duration] : histogram()) {
+        double share = total > SC_ZERO_TIME ? duration / total * 100.0 : 0.0;
+        os << std::endl
+           << "  " << quantum << ": " << duration << " ("
+           << std::fixed << std::setprecision(1) << share << "%)";
+    }
+
+    return true;
+}
+
+adaptive_quantum::adaptive_quantum(const sc_module_name& nm):
+    module(nm),
+    m_interactions(0),
+    m_quiet(0),
+    m_num_grow(0),
+    m_num_shrink(0),
+    m_last(SC_ZERO_TIME),
+    m_histogram(),
+    min_quantum("min_quantum", sc_time(1, SC_US)),
+    max_quantum("max_quantum", sc_time(100, SC_US)),
+    update_interval("update_interval", sc_time(1, SC_MS)),
+    grow_threshold("grow_threshold", 0),
+    shrink_threshold("shrink_threshold", 10),
+    hysteresis("hysteresis", 4),
+    grow_factor("grow_factor", 2.0),
+    shrink_factor("shrink_factor", 0.5) {
+    VCML_ERROR_ON(min_quantum > max_quantum, "min_quantum above max_quantum");
+    VCML_ERROR_ON(grow_factor <= 1.0, "grow_factor must be above 1.0");
+    VCML_ERROR_ON(shrink_factor <= 0.0 || shrink_factor >= 1.0,
+                  "shrink_factor must be between 0.0 and 1.0");
+    VCML_ERROR_ON(update_interval == SC_ZERO_TIME, "zero update_interval");
+
+    SC_HAS_PROCESS(adaptive_quantum);
+    SC_METHOD(update);
+
+    register_command("show_stats", 0, &adaptive_quantum::cmd_show_stats,
+                     "shows statistics about quantum size over time");
+}
+
+void adaptive_quantum::start_of_simulation() {
+    module::start_of_simulation();
+
+    sc_time quantum = current_quantum();
+    if (quantum < min_quantum)
+        quantum = min_quantum;
+    if (quantum > max_quantum)
+        quantum = max_quantum;
+
+    tlm::tlm_global_quantum::instance().set(quantum);
+    m_interactions = interaction_count();
+    m_last = sc_time_stamp();
+}
+
+void adaptive_quantum::end_of_simulation() {
+    account();
+    log_debug("quantum increased %zu times, decreased %zu times",
+              m_num_grow, m_num_shrink);
+    module::end_of_simulation();
+}
+
+VCML_EXPORT_MODEL(vcml::meta::adaptive_quantum, name, args) {
+    return new adaptive_quantum(name);
+}
+
+} // namespace meta
+} // namespace vcml
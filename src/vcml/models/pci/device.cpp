@@ -495,11 +495,11 @@ void device::pci_bypass_cfgro(bool enable) {
 }
 
 void device::pci_transport(const pci_target_socket& sck, pci_payload& pci) {
-    tlm_generic_payload tx;
+    tlm_pooled_tx tx(tx_pool());
     tlm_command cmd = pci_translate_command(pci.command);
-    tx_setup(tx, cmd, pci.addr, &pci.data, pci.size);
-    receive(tx, pci.debug ? SBI_DEBUG : SBI_NONE, pci.space);
-    pci.response = pci_translate_response(tx.get_response_status());
+    tx_setup(*tx, cmd, pci.addr, &pci.data, pci.size);
+    receive(*tx, pci.debug ? SBI_DEBUG : SBI_NONE, pci.space);
+    pci.response = pci_translate_response(tx->get_response_status());
 }
 
 bool device::read_mem_bar(const range& addr, void* data, const tlm_sbi& sbi,
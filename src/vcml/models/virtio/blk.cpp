@@ -32,6 +32,7 @@ enum features : u64 {
     VIRTIO_BLK_F_FLUSH = bit(9),
     VIRTIO_BLK_F_TOPOLOGY = bit(10),
     VIRTIO_BLK_F_CONFIG_WCE = bit(11),
+    VIRTIO_BLK_F_MQ = bit(12),
     VIRTIO_BLK_F_DISCARD = bit(13),
     VIRTIO_BLK_F_WRITE_ZEROES = bit(14),
 };
@@ -66,8 +67,9 @@ static void put_status(vq_message& msg, u8 status) {
     msg.copy_out(status, sz - 1);
 }
 
-bool blk::process_command(vq_message& msg) {
+bool blk::process_command(io_request& io) {
     virtio_blk_req req = {};
+    vq_message& msg = io.msg;
     if (msg.length_in() < sizeof(req) || msg.length_out() < sizeof(u8)) {
         log_error("message does not hold required request fields");
         return false;
@@ -80,146 +82,201 @@ bool blk::process_command(vq_message& msg) {
 
     switch (req.type) {
     case VIRTIO_BLK_T_IN:
-        return process_in(req, msg);
+        return process_in(req, io);
 
     case VIRTIO_BLK_T_OUT:
-        return process_out(req, msg);
+        return process_out(req, io);
 
     case VIRTIO_BLK_T_FLUSH:
-        return process_flush(req, msg);
+        return process_flush(req, io);
 
     case VIRTIO_BLK_T_GET_ID:
-        return process_get_id(req, msg);
+        return process_get_id(req, io);
 
     case VIRTIO_BLK_T_DISCARD:
-        return process_discard(req, msg);
+        return process_discard(req, io);
 
     case VIRTIO_BLK_T_WRITE_ZEROES:
-        return process_write_zeroes(req, msg);
+        return process_write_zeroes(req, io);
 
     default:
         log_warn("unsupported request: %u", req.type);
-        put_status(msg, VIRTIO_BLK_S_UNSUPP);
+        finish(io, VIRTIO_BLK_S_UNSUPP);
         return true;
     }
 }
 
-bool blk::process_in(virtio_blk_req& req, vq_message& msg) {
-    size_t length = msg.length_out() - 1;
-    log_debug("read sector %llu, %zu bytes", req.sector, length);
-    if (length % SECTOR_SIZE) {
-        log_warn("data length is not a multiple of sector size");
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
-    }
+// collects the host pointers of the guest buffers covering the given range
+// into the disk request, merging neighbors that are adjacent in host memory
+bool blk::map_buffers(io_request& io, bool out, size_t off, size_t len) {
+    const auto& bufs = out ? io.msg.out : io.msg.in;
+    vcml_access acs = out ? VCML_ACCESS_WRITE : VCML_ACCESS_READ;
+    vector<block::iobuf>& iov = io.disk_req.iov;
+
+    iov.clear();
+    for (const auto& buf : bufs) {
+        if (len == 0)
+            break;
+
+        if (off >= buf.size) {
+            off -= buf.size;
+            continue;
+        }
 
-    if (!disk.seek(req.sector * SECTOR_SIZE)) {
-        log_warn("seek request failed for sector %llu", req.sector);
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
+        size_t n = min<size_t>(len, buf.size - off);
+        u8* ptr = io.msg.dmi(buf.addr + off, n, acs);
+        if (ptr == nullptr)
+            return false;
+
+        if (!iov.empty() && iov.back().ptr + iov.back().size == ptr)
+            iov.back().size += n;
+        else
+            iov.push_back({ ptr, n });
+
+        off = 0;
+        len -= n;
     }
 
-    u8 sector[SECTOR_SIZE];
-    for (size_t count = 0; count < length; count += SECTOR_SIZE) {
-        if (!disk.read(sector, SECTOR_SIZE)) {
-            log_warn("disk read request failed");
-            put_status(msg, VIRTIO_BLK_S_IOERR);
-            return true;
+    return len == 0;
+}
+
+void blk::submit(io_request& io, block::disk::request_type type, u64 sector,
+                 size_t size) {
+    block::disk::request& dreq = io.disk_req;
+    dreq.type = type;
+    dreq.offset = sector * SECTOR_SIZE;
+    dreq.size = size;
+    dreq.success = false;
+    dreq.complete = [this, &io](block::disk::request& r) -> void {
+        if (io.epoch != m_epoch) {
+            finish(io, VIRTIO_BLK_S_IOERR);
+            return;
+        }
+
+        if (!r.success) {
+            log_warn("disk request failed for sector %llu", io.sector);
+            finish(io, VIRTIO_BLK_S_IOERR);
+            return;
         }
 
-        msg.copy_out(sector, count);
+        if (r.type == block::disk::REQ_READ && !io.bounce.empty())
+            io.msg.copy_out(io.bounce.data(), io.bounce.size());
+
+        finish(io, VIRTIO_BLK_S_OK);
+    };
+
+    io.sector = sector;
+    disk.submit(dreq);
+}
+
+void blk::finish(io_request& io, u8 status) {
+    // requests from before the last reset must not touch guest memory
+    if (io.epoch == m_epoch)
+        put_status(io.msg, status);
+    io.done = true;
+    retire(io.vqid);
+}
+
+bool blk::retire(u32 vqid) {
+    auto& requests = m_queues[vqid];
+    bool success = true;
+    auto it = requests.begin();
+    while (it != requests.end()) {
+        io_request& io = **it;
+        if (!io.done) {
+            if (m_in_order)
+                break;
+            it++;
+            continue;
+        }
+
+        // requests from before the last reset must not reach the new rings
+        if (io.epoch == m_epoch && !virtio_in->put(io.vqid, io.msg))
+            success = false;
+
+        it = requests.erase(it);
     }
 
-    put_status(msg, VIRTIO_BLK_S_OK);
-    return true;
+    return success;
 }
 
-bool blk::process_out(virtio_blk_req& req, vq_message& msg) {
-    size_t length = msg.length_in() - sizeof(req);
-    log_debug("write sector %llu, %zu bytes", req.sector, length);
+bool blk::process_in(virtio_blk_req& req, io_request& io) {
+    size_t length = io.msg.length_out() - 1;
+    log_debug("read sector %llu, %zu bytes", req.sector, length);
     if (length % SECTOR_SIZE) {
         log_warn("data length is not a multiple of sector size");
-        put_status(msg, VIRTIO_BLK_S_IOERR);
+        finish(io, VIRTIO_BLK_S_IOERR);
         return true;
     }
 
-    if (!disk.seek(req.sector * SECTOR_SIZE)) {
-        log_warn("seek request failed for sector %llu", req.sector);
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
+    if (!map_buffers(io, true, 0, length)) {
+        io.bounce.resize(length);
+        io.disk_req.iov.assign(1, { io.bounce.data(), length });
     }
 
-    u8 sector[SECTOR_SIZE];
-    for (size_t count = 0; count < length; count += SECTOR_SIZE) {
-        msg.copy_in(sector, count + sizeof(req));
+    submit(io, block::disk::REQ_READ, req.sector, length);
+    return true;
+}
+
+bool blk::process_out(virtio_blk_req& req, io_request& io) {
+    size_t length = io.msg.length_in() - sizeof(req);
+    log_debug("write sector %llu, %zu bytes", req.sector, length);
+    if (length % SECTOR_SIZE) {
+        log_warn("data length is not a multiple of sector size");
+        finish(io, VIRTIO_BLK_S_IOERR);
+        return true;
+    }
 
-        if (!disk.write(sector, SECTOR_SIZE)) {
-            log_warn("disk write request failed");
-            put_status(msg, VIRTIO_BLK_S_IOERR);
-            return true;
-        }
+    if (!map_buffers(io, false, sizeof(req), length)) {
+        vector<u8> data(length);
+        io.msg.copy_in(data.data(), length, sizeof(req));
+        io.disk_req.iov.assign(1, { data.data(), length });
+        io.bounce.swap(data);
     }
 
-    put_status(msg, VIRTIO_BLK_S_OK);
+    submit(io, block::disk::REQ_WRITE, req.sector, length);
     return true;
 }
 
-bool blk::process_flush(virtio_blk_req& req, vq_message& msg) {
+bool blk::process_flush(virtio_blk_req& req, io_request& io) {
     log_debug("flush disk request");
-    if (!disk.flush()) {
-        log_warn("disk flush request failed");
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
-    }
-
-    put_status(msg, VIRTIO_BLK_S_OK);
+    submit(io, block::disk::REQ_FLUSH, 0, 0);
     return true;
 }
 
-bool blk::process_get_id(virtio_blk_req& req, vq_message& msg) {
+bool blk::process_get_id(virtio_blk_req& req, io_request& io) {
     log_debug("get_id request");
     char buffer[20] = {};
     snprintf(buffer, sizeof(buffer), "%s", disk.serial.get().c_str());
-    msg.copy_in(buffer);
-    put_status(msg, VIRTIO_BLK_S_OK);
+    io.msg.copy_in(buffer);
+    finish(io, VIRTIO_BLK_S_OK);
     return true;
 }
 
-bool blk::process_discard(virtio_blk_req& req, vq_message& msg) {
+bool blk::process_discard(virtio_blk_req& req, io_request& io) {
     virtio_blk_dwz dwz;
-    if (msg.copy_in(dwz, sizeof(req)) != sizeof(dwz)) {
+    if (io.msg.copy_in(dwz, sizeof(req)) != sizeof(dwz)) {
         log_error("unable to read discard arguments");
         return false;
     }
 
     size_t length = dwz.num_sectors * SECTOR_SIZE;
     log_debug("discard sector %llu, %zu bytes", dwz.sector, length);
-    put_status(msg, VIRTIO_BLK_S_OK);
+    submit(io, block::disk::REQ_DISCARD, dwz.sector, length);
     return true;
 }
 
-bool blk::process_write_zeroes(virtio_blk_req& req, vq_message& msg) {
+bool blk::process_write_zeroes(virtio_blk_req& req, io_request& io) {
     virtio_blk_dwz dwz;
-    if (msg.copy_in(dwz, sizeof(req)) != sizeof(dwz)) {
+    if (io.msg.copy_in(dwz, sizeof(req)) != sizeof(dwz)) {
         log_error("unable to read discard arguments");
         return false;
     }
 
-    if (!disk.seek(dwz.sector * SECTOR_SIZE)) {
-        log_warn("seek request failed for sector %llu", dwz.sector);
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
-    }
-
     size_t length = dwz.num_sectors * SECTOR_SIZE;
     log_debug("write zeros to sector %llu, %zu bytes", dwz.sector, length);
-    if (!disk.wzero(length, dwz.flags & VIRTIO_BLK_FLAG_UNMAP)) {
-        log_warn("write zero request failed for sector %llu", dwz.sector);
-        put_status(msg, VIRTIO_BLK_S_IOERR);
-        return true;
-    }
-
-    put_status(msg, VIRTIO_BLK_S_OK);
+    io.disk_req.may_unmap = dwz.flags & VIRTIO_BLK_FLAG_UNMAP;
+    submit(io, block::disk::REQ_WZERO, dwz.sector, length);
     return true;
 }
 
@@ -228,23 +285,37 @@ void blk::identify(virtio_device_desc& desc) {
     desc.device_id = VIRTIO_DEVICE_BLOCK;
     desc.vendor_id = VIRTIO_VENDOR_VCML;
     desc.pci_class = PCI_CLASS_STORAGE_SCSI;
-    desc.request_virtqueue(VIRTQUEUE_REQUEST, VIRTQUEUE0_LENGTH);
+    for (u32 i = 0; i < m_queues.size(); i++)
+        desc.request_virtqueue(VIRTQUEUE_REQUEST + i, VIRTQUEUE0_LENGTH);
 }
 
 bool blk::notify(u32 vqid) {
-    vq_message msg;
-
-    while (virtio_in->get(vqid, msg)) {
-        log_debug("received message from virtqueue %u with %u bytes", vqid,
-                  msg.length());
+    if (vqid >= m_queues.size()) {
+        log_warn("notification for invalid virtqueue %u", vqid);
+        return false;
+    }
 
-        process_command(msg);
+    while (true) {
+        auto io = std::make_unique<io_request>();
+        if (!virtio_in->get(vqid, io->msg))
+            break;
 
-        if (!virtio_in->put(vqid, msg))
-            return false;
+        log_debug("received message from virtqueue %u with %u bytes", vqid,
+                  io->msg.length());
+
+        io->vqid = vqid;
+        io->epoch = m_epoch;
+        io->sector = 0;
+        io->done = false;
+
+        // completion may retire the request before process_command returns
+        io_request& ref = *io;
+        m_queues[vqid].push_back(std::move(io));
+        if (!process_command(ref))
+            ref.done = true;
     }
 
-    return true;
+    return retire(vqid);
 }
 
 void blk::read_features(u64& features) {
@@ -265,9 +336,12 @@ void blk::read_features(u64& features) {
         features |= VIRTIO_BLK_F_GEOMETRY;
     if (m_config.topology.min_io_size)
         features |= VIRTIO_BLK_F_TOPOLOGY;
+    if (m_config.num_queues > 1)
+        features |= VIRTIO_BLK_F_MQ;
 }
 
 bool blk::write_features(u64 features) {
+    m_in_order = features & (VIRTIO_F_IN_ORDER | VIRTIO_F_RING_PACKED);
     return disk.readonly == !!(features & VIRTIO_BLK_F_RO);
 }
 
@@ -287,11 +361,15 @@ blk::blk(const sc_module_name& nm):
     module(nm),
     virtio_device(),
     m_config(),
+    m_in_order(false),
+    m_epoch(0),
+    m_queues(),
     image("image", ""),
     readonly("readonly", false),
     max_size("max_size", 4096),
     max_discard_sectors("max_discard_sectors", 4096),
     max_write_zeroes_sectors("max_write_zeroes_sectors", 4096),
+    num_queues("num_queues", 1),
     disk("disk", image, readonly),
     virtio_in("virtio_in") {
     m_config.capacity = disk.capacity() / SECTOR_SIZE;
@@ -304,6 +382,14 @@ blk::blk(const sc_module_name& nm):
     m_config.max_write_zeroes_sectors = max_write_zeroes_sectors;
     m_config.max_write_zeroes_seg = 1;
     m_config.write_zeroes_may_unmap = true;
+
+    if (num_queues == 0 || num_queues > 0xffff) {
+        log_warn("invalid number of queues: %u", num_queues.get());
+        num_queues = 1;
+    }
+
+    m_queues.resize(num_queues);
+    m_config.num_queues = num_queues;
 }
 
 blk::~blk() {
@@ -311,7 +397,15 @@ blk::~blk() {
 }
 
 void blk::reset() {
-    // nothing to do
+    // the guest may reuse its buffers right after the reset, so wait for
+    // running disk requests to finish and cancel the others; their results
+    // belong to the old epoch and never reach the guest
+    m_epoch++;
+    m_in_order = false;
+    disk.drain();
+
+    for (u32 vqid = 0; vqid < m_queues.size(); vqid++)
+        retire(vqid);
 }
 
 VCML_EXPORT_MODEL(vcml::virtio::blk, name, args) {
@@ -229,7 +229,7 @@ void net::handle_ctrl_mac_addr(vq_message& msg) {
     }
 }
 
-bool net::handle_rx(vq_message& msg, eth_frame& frame) {
+bool net::handle_rx(vq_message& msg, const eth_frame& frame) {
     if (msg.length_out() < frame.size() + sizeof(virtio_net_hdr)) {
         log_warn("reception buffer too small: %u", msg.length_out());
         return false;
@@ -268,7 +268,7 @@ bool net::handle_tx(vq_message& msg) {
     }
 
     eth_frame frame(msg.length_in() - sizeof(header));
-    msg.copy_in(frame.data(), frame.size(), sizeof(header));
+    msg.copy_in(frame.mutable_data(), frame.size(), sizeof(header));
 
     if (frame.size() < eth_frame::FRAME_MIN_SIZE)
         frame.resize(eth_frame::FRAME_MIN_SIZE);
@@ -37,43 +37,142 @@ string mac_addr::to_string() const {
                  bytes[5]);
 }
 
-eth_frame::eth_frame(const vector<u8>& raw): vector<u8>(raw) {
-    if (size() > FRAME_MAX_SIZE)
+struct eth_frame::pool {
+    mutex mtx;
+    vector<buffer*> free;
+
+    ~pool() {
+        for (buffer* buf : free)
+            delete buf;
+    }
+
+    static pool& instance() {
+        static pool singleton;
+        return singleton;
+    }
+};
+
+const vector<u8> eth_frame::NO_DATA;
+
+eth_frame::buffer* eth_frame::allocate() {
+    pool& p = pool::instance();
+    buffer* buf = nullptr;
+
+    {
+        lock_guard<mutex> guard(p.mtx);
+        if (!p.free.empty()) {
+            buf = p.free.back();
+            p.free.pop_back();
+        }
+    }
+
+    if (buf == nullptr)
+        buf = new buffer();
+
+    buf->refs.store(1, std::memory_order_relaxed);
+    buf->bytes.reserve(FRAME_MAX_SIZE);
+    return buf;
+}
+
+void eth_frame::release(buffer* buf) {
+    if (buf == nullptr)
+        return;
+
+    if (buf->refs.fetch_sub(1, std::memory_order_acq_rel) > 1)
+        return;
+
+    buf->bytes.clear();
+
+    pool& p = pool::instance();
+    {
+        lock_guard<mutex> guard(p.mtx);
+        if (p.free.size() < POOL_LIMIT) {
+            p.free.push_back(buf);
+            return;
+        }
+    }
+
+    delete buf;
+}
+
+size_t eth_frame::pool_size() {
+    pool& p = pool::instance();
+    lock_guard<mutex> guard(p.mtx);
+    return p.free.size();
+}
+
+vector<u8>& eth_frame::writable() {
+    if (m_buf == nullptr) {
+        m_buf = allocate();
+    } else if (m_buf->refs.load(std::memory_order_acquire) > 1) {
+        buffer* copy = allocate();
+        copy->bytes.assign(m_buf->bytes.begin(), m_buf->bytes.end());
+        release(m_buf);
+        m_buf = copy;
+    }
+
+    return m_buf->bytes;
+}
+
+void eth_frame::pad() {
+    if (m_buf->bytes.size() < FRAME_MIN_SIZE)
+        m_buf->bytes.resize(FRAME_MIN_SIZE);
+}
+
+eth_frame::eth_frame(size_t length): m_buf(allocate()) {
+    m_buf->bytes.resize(length);
+}
+
+eth_frame::eth_frame(const vector<u8>& raw): m_buf(nullptr) {
+    if (raw.size() > FRAME_MAX_SIZE)
         VCML_ERROR("payload too big");
-    while (size() < FRAME_MIN_SIZE)
-        push_back(0);
+    m_buf = allocate();
+    m_buf->bytes.assign(raw.begin(), raw.end());
+    pad();
 }
 
-eth_frame::eth_frame(vector<u8>&& frame): vector<u8>(std::move(frame)) {
-    if (size() > FRAME_MAX_SIZE)
+eth_frame::eth_frame(vector<u8>&& frame): m_buf(nullptr) {
+    if (frame.size() > FRAME_MAX_SIZE)
         VCML_ERROR("payload too big");
-    while (size() < FRAME_MIN_SIZE)
-        push_back(0);
+    m_buf = allocate();
+
+    // taking over a small vector would free the reserved pool storage
+    if (frame.capacity() >= FRAME_MAX_SIZE)
+        m_buf->bytes = std::move(frame);
+    else
+        m_buf->bytes.assign(frame.begin(), frame.end());
+    pad();
 }
 
-eth_frame::eth_frame(const u8* data, size_t len):
-    vector<u8>(data, data + len) {
-    if (size() > FRAME_MAX_SIZE)
+eth_frame::eth_frame(const u8* data, size_t len): m_buf(nullptr) {
+    if (len > FRAME_MAX_SIZE)
         VCML_ERROR("payload too big");
-    while (size() < FRAME_MIN_SIZE)
-        push_back(0);
+    m_buf = allocate();
+    m_buf->bytes.assign(data, data + len);
+    pad();
 }
 
 eth_frame::eth_frame(const mac_addr& dest, const mac_addr& src,
-                     const vector<u8>& payload) {
-    insert(end(), dest.bytes.begin(), dest.bytes.end());
-    insert(end(), src.bytes.begin(), src.bytes.end());
+                     const vector<u8>& payload):
+    m_buf(nullptr) {
+    if (payload.size() + FRAME_HEADER_SIZE > FRAME_MAX_SIZE)
+        VCML_ERROR("payload too big");
+
+    m_buf = allocate();
+    vector<u8>& raw = m_buf->bytes;
+    raw.insert(raw.end(), dest.bytes.begin(), dest.bytes.end());
+    raw.insert(raw.end(), src.bytes.begin(), src.bytes.end());
 
     u16 len = payload.size();
-    push_back(len >> 0);
-    push_back(len >> 8);
+    raw.push_back(len >> 0);
+    raw.push_back(len >> 8);
 
-    insert(end(), payload.begin(), payload.end());
+    raw.insert(raw.end(), payload.begin(), payload.end());
+    pad();
+}
 
-    if (size() > FRAME_MAX_SIZE)
-        VCML_ERROR("payload too big");
-    while (size() < FRAME_MIN_SIZE)
-        push_back(0);
+bool eth_frame::operator==(const eth_frame& other) const {
+    return shares(other) || bytes() == other.bytes();
 }
 
 u16 eth_frame::ether_type() const {
@@ -403,11 +502,12 @@ void eth_initiator_socket::send(const vector<u8>& data) {
     send(frame);
 }
 
-void eth_initiator_socket::send(eth_frame& frame) {
-    trace_fw(frame);
+void eth_initiator_socket::send(const eth_frame& frame) {
+    eth_frame clone(frame);
+    trace_fw(clone);
     if (m_link_up)
-        get_interface(0)->eth_transport(frame);
-    trace_bw(frame);
+        get_interface(0)->eth_transport(clone);
+    trace_bw(clone);
 }
 
 void eth_target_socket::eth_transport(eth_frame& frame) {
@@ -44,12 +44,44 @@ static tlm_dmi dmi_merge(const tlm_dmi& a, const tlm_dmi& b) {
     return result;
 }
 
-tlm_dmi_cache::tlm_dmi_cache(): m_limit(16), m_entries() {
+// Lookups first consult a small per-thread table of recent hits, which is
+// only valid as long as the generation of the owning cache is unchanged.
+// Generations are drawn from a global counter, so a new cache allocated at
+// the address of a deleted one will never match a stale slot.
+struct dmi_slot {
+    const tlm_dmi_cache* owner;
+    u64 generation;
+    tlm_dmi dmi;
+};
+
+static constexpr size_t NUM_DMI_SLOTS = 8;
+static thread_local dmi_slot g_dmi_slots[NUM_DMI_SLOTS];
+static atomic<u64> g_dmi_generation(0);
+
+static dmi_slot& dmi_lookup_slot(const tlm_dmi_cache* cache) {
+    uintptr_t hash = reinterpret_cast<uintptr_t>(cache) >> 4;
+    return g_dmi_slots[(hash ^ (hash >> 7)) % NUM_DMI_SLOTS];
+}
+
+static u64 dmi_next_generation() {
+    return ++g_dmi_generation;
+}
+
+tlm_dmi_cache::tlm_dmi_cache():
+    m_mtx(),
+    m_limit(16),
+    m_entries(),
+    m_generation(dmi_next_generation()),
+    m_snapshot(nullptr),
+    m_readers(0),
+    m_retired() {
     // nothing to do
 }
 
 tlm_dmi_cache::~tlm_dmi_cache() {
-    // nothing to do
+    for (const snapshot* snap : m_retired)
+        delete snap;
+    delete m_snapshot.load();
 }
 
 void tlm_dmi_cache::insert_locked(const tlm_dmi& dmi) {
@@ -74,9 +106,40 @@ void tlm_dmi_cache::insert_locked(const tlm_dmi& dmi) {
         m_entries.resize(m_limit);
 }
 
+void tlm_dmi_cache::publish_locked() {
+    snapshot* snap = new snapshot;
+    snap->entries = m_entries;
+    std::stable_sort(snap->entries.begin(), snap->entries.end(),
+                     [](const tlm_dmi& a, const tlm_dmi& b) -> bool {
+                         return a.get_start_address() < b.get_start_address();
+                     });
+
+    u64 maxend = 0;
+    snap->maxend.reserve(snap->entries.size());
+    for (const tlm_dmi& dmi : snap->entries) {
+        maxend = max<u64>(maxend, dmi.get_end_address());
+        snap->maxend.push_back(maxend);
+    }
+
+    const snapshot* old = m_snapshot.exchange(snap);
+    m_generation.store(dmi_next_generation(), std::memory_order_release);
+
+    if (old)
+        m_retired.push_back(old);
+
+    // readers register before loading the snapshot pointer, so if there are
+    // none now, nobody can still be looking at any of the retired snapshots
+    if (m_readers.load() == 0) {
+        for (const snapshot* retired : m_retired)
+            delete retired;
+        m_retired.clear();
+    }
+}
+
 void tlm_dmi_cache::insert(const tlm_dmi& dmi) {
     lock_guard<mutex> guard(m_mtx);
     insert_locked(dmi);
+    publish_locked();
 }
 
 bool tlm_dmi_cache::invalidate(u64 start, u64 end) {
@@ -113,20 +176,58 @@ bool tlm_dmi_cache::invalidate(const range& r) {
         }
     }
 
+    if (invalidations > 0)
+        publish_locked();
+
     return invalidations > 0;
 }
 
-bool tlm_dmi_cache::lookup(const range& r, vcml_access rwx, tlm_dmi& out) {
-    lock_guard<mutex> guard(m_mtx);
-    for (unsigned int i = 0; i < m_entries.size(); i++) {
-        if (r.inside(m_entries[i]) && dmi_check_access(m_entries[i], rwx)) {
-            std::swap(m_entries[i], m_entries[0]);
-            out = m_entries[0];
-            return true;
+bool tlm_dmi_cache::lookup_snapshot(const range& r, vcml_access rwx,
+                                    tlm_dmi& out) {
+    m_readers++;
+
+    bool found = false;
+    const snapshot* snap = m_snapshot.load();
+    if (snap != nullptr) {
+        const vector<tlm_dmi>& entries = snap->entries;
+        auto it = std::upper_bound(entries.begin(), entries.end(), r.start,
+                                   [](u64 addr, const tlm_dmi& dmi) -> bool {
+                                       return addr < dmi.get_start_address();
+                                   });
+
+        for (size_t i = it - entries.begin(); i > 0; i--) {
+            const tlm_dmi& dmi = entries[i - 1];
+            if (snap->maxend[i - 1] < r.end)
+                break;
+
+            if (r.inside(dmi) && dmi_check_access(dmi, rwx)) {
+                out = dmi;
+                found = true;
+                break;
+            }
         }
     }
 
-    return false;
+    m_readers--;
+    return found;
+}
+
+bool tlm_dmi_cache::lookup(const range& r, vcml_access rwx, tlm_dmi& out) {
+    dmi_slot& slot = dmi_lookup_slot(this);
+    u64 generation = m_generation.load(std::memory_order_acquire);
+    if (slot.owner == this && slot.generation == generation &&
+        r.inside(slot.dmi) && dmi_check_access(slot.dmi, rwx)) {
+        out = slot.dmi;
+        return true;
+    }
+
+    if (!lookup_snapshot(r, rwx, out))
+        return false;
+
+    slot.owner = this;
+    slot.generation = generation;
+    slot.dmi = out;
+    return true;
 }
 
 } // namespace vcml
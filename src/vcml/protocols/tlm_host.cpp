@@ -16,10 +16,10 @@ namespace vcml {
 unsigned int tlm_host::do_transport(tlm_target_socket& socket,
                                     tlm_generic_payload& tx,
                                     const tlm_sbi& info) {
-    sc_process_b* proc = current_process();
+    proc_data& data = get_proc_data(current_process());
 
-    m_processes[proc].tx = &tx;
-    m_processes[proc].sbi = &info;
+    data.tx = &tx;
+    data.sbi = &info;
 
     if (tx.get_response_status() != TLM_INCOMPLETE_RESPONSE)
         VCML_ERROR("invalid in-bound transaction response status");
@@ -29,12 +29,20 @@ unsigned int tlm_host::do_transport(tlm_target_socket& socket,
     if (tx.get_response_status() == TLM_INCOMPLETE_RESPONSE)
         VCML_ERROR("invalid out-bound transaction response status");
 
-    m_processes[proc].tx = nullptr;
-    m_processes[proc].sbi = nullptr;
+    data.tx = nullptr;
+    data.sbi = nullptr;
 
     return n;
 }
 
+tlm_host::proc_data& tlm_host::new_proc_data(size_t index) const {
+    if (index >= m_processes.size())
+        m_processes.resize(index + 1);
+    if (!m_processes[index])
+        m_processes[index].reset(new proc_data());
+    return *m_processes[index];
+}
+
 void tlm_host::register_socket(tlm_initiator_socket* socket) {
     if (stl_contains(m_initiator_sockets, socket))
         VCML_ERROR("socket '%s' already registered", socket->name());
@@ -83,14 +91,12 @@ tlm_host::tlm_host(bool allow_dmi, unsigned int bus_width):
     m_processes(),
     m_initiator_sockets(),
     m_target_sockets(),
+    m_tx_pool(),
     allow_dmi("allow_dmi", allow_dmi) {
 }
 
 sc_time& tlm_host::local_time(sc_process_b* proc) {
-    if (!stl_contains(m_processes, proc))
-        m_processes[proc].time = SC_ZERO_TIME;
-
-    sc_time& local = m_processes[proc].time;
+    sc_time& local = get_proc_data(proc).time;
     update_local_time(local, proc);
     return local;
 }
@@ -156,9 +162,10 @@ void tlm_host::b_transport(tlm_target_socket& socket, tlm_generic_payload& tx,
                            sc_time& dt) {
     sc_process_b* proc = current_thread();
     VCML_ERROR_ON(!proc, "b_transport outside SC_THREAD");
-    m_processes[proc].time = dt;
+    proc_data& data = get_proc_data(proc);
+    data.time = dt;
     do_transport(socket, tx, socket.current_sideband());
-    dt = m_processes[proc].time;
+    dt = data.time;
 }
 
 unsigned int tlm_host::transport_dbg(tlm_target_socket& socket,
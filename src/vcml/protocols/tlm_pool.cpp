@@ -0,0 +1,67 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/protocols/tlm_pool.h"
+#include "vcml/core/thctl.h"
+
+namespace vcml {
+
+tlm_pool::tlm_pool(): m_mtx(), m_free(), m_local(), m_hits(0), m_misses(0) {
+    // nothing to do
+}
+
+tlm_pool::~tlm_pool() {
+    for (tlm_generic_payload* tx : m_free)
+        delete tx;
+    for (tlm_generic_payload* tx : m_local)
+        delete tx;
+}
+
+tlm_generic_payload* tlm_pool::allocate() {
+    tlm_generic_payload* tx = nullptr;
+
+    if (thctl_is_sysc_thread() && !m_local.empty()) {
+        tx = m_local.back();
+        m_local.pop_back();
+    } else {
+        lock_guard<mutex> guard(m_mtx);
+        if (!m_free.empty()) {
+            tx = m_free.back();
+            m_free.pop_back();
+        }
+    }
+
+    if (tx == nullptr) {
+        m_misses.fetch_add(1, std::memory_order_relaxed);
+        tx = new tlm_generic_payload(this);
+        tx->set_extension(new sbiext());
+    } else {
+        m_hits.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    tx->acquire();
+    return tx;
+}
+
+void tlm_pool::free(tlm_generic_payload* tx) {
+    tx->reset();
+    tx_setup(*tx, TLM_IGNORE_COMMAND, 0, nullptr, 0);
+    tx_set_sbi(*tx, SBI_NONE);
+
+    if (thctl_is_sysc_thread()) {
+        m_local.push_back(tx);
+        return;
+    }
+
+    lock_guard<mutex> guard(m_mtx);
+    m_free.push_back(tx);
+}
+
+} // namespace vcml
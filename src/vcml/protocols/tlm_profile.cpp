@@ -0,0 +1,139 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/protocols/tlm_profile.h"
+
+namespace vcml {
+
+tlm_profile_counters& tlm_profile_counters::operator+=(
+    const tlm_profile_counters& other) {
+    count += other.count;
+    bytes += other.bytes;
+    host_ns += other.host_ns;
+    dmi += other.dmi;
+    debug += other.debug;
+    errors += other.errors;
+    return *this;
+}
+
+// profile ids are never reused, so stale entries left behind by destroyed
+// profiles cannot be mistaken for shards of new ones
+static atomic<u64> g_profile_ids(0);
+static thread_local unordered_map<u64, void*> g_profile_shards;
+
+tlm_profile::shard& tlm_profile::local_shard() {
+    auto it = g_profile_shards.find(m_id);
+    if (it != g_profile_shards.end())
+        return *static_cast<shard*>(it->second);
+
+    lock_guard<mutex> guard(m_mtx);
+    m_shards.emplace_back(new shard());
+    g_profile_shards[m_id] = m_shards.back().get();
+    return *m_shards.back();
+}
+
+tlm_profile::tlm_profile(u64 granule):
+    m_id(++g_profile_ids), m_granule(granule), m_mtx(), m_shards() {
+    VCML_ERROR_ON(!granule, "profile granule cannot be zero");
+}
+
+tlm_profile::~tlm_profile() {
+    g_profile_shards.erase(m_id);
+}
+
+void tlm_profile::record(u64 addr, unsigned int bytes, u64 host_ns, bool dmi,
+                         bool debug, bool error) {
+    shard& s = local_shard();
+    lock_guard<mutex> guard(s.mtx); // uncontended unless reporting
+    tlm_profile_counters& c = s.buckets[addr / m_granule];
+    c.count++;
+    c.bytes += bytes;
+    c.host_ns += host_ns;
+    c.dmi += dmi ? 1 : 0;
+    c.debug += debug ? 1 : 0;
+    c.errors += error ? 1 : 0;
+}
+
+vector<tlm_profile::entry> tlm_profile::collect() const {
+    unordered_map<u64, tlm_profile_counters> merged;
+
+    {
+        lock_guard<mutex> guard(m_mtx);
+        for (const auto& s : m_shards) {
+            lock_guard<mutex> shard_guard(s->mtx);
+            for (const auto& [bucket, counters] : s->buckets)
+                merged[bucket] += counters;
+        }
+    }
+
+    vector<entry> entries;
+    entries.reserve(merged.size());
+    for (const auto& [bucket, counters] : merged) {
+        u64 start = bucket * m_granule;
+        entries.push_back({ range(start, start + m_granule - 1), counters });
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const entry& a, const entry& b) -> bool {
+                  if (a.counters.host_ns != b.counters.host_ns)
+                      return a.counters.host_ns > b.counters.host_ns;
+                  return a.addr.start < b.addr.start;
+              });
+
+    return entries;
+}
+
+tlm_profile_counters tlm_profile::total() const {
+    tlm_profile_counters total{};
+    for (const entry& e : collect())
+        total += e.counters;
+    return total;
+}
+
+void tlm_profile::reset() {
+    lock_guard<mutex> guard(m_mtx);
+    for (const auto& s : m_shards) {
+        lock_guard<mutex> shard_guard(s->mtx);
+        s->buckets.clear();
+    }
+}
+
+void tlm_profile::report(ostream& os) const {
+    stream_guard guard(os);
+
+    vector<entry> entries = collect();
+    tlm_profile_counters sum{};
+    for (const entry& e : entries)
+        sum += e.counters;
+
+    os << sum.count << " transactions, " << sum.bytes << " bytes, "
+       << sum.host_ns / 1000 << "us host time";
+
+    for (const entry& e : entries) {
+        const tlm_profile_counters& c = e.counters;
+        double share = sum.host_ns ? 100.0 * c.host_ns / sum.host_ns : 0.0;
+        double dmi = c.count ? 100.0 * c.dmi / c.count : 0.0;
+        double avg = c.count ? (double)c.host_ns / c.count : 0.0;
+
+        os << std::endl
+           << "  " << std::hex << std::setfill('0') << std::setw(16)
+           << e.addr.start << ".." << std::setw(16) << e.addr.end
+           << std::dec << std::setfill(' ') << ": " << c.count << " tx, "
+           << c.bytes << " bytes, " << std::fixed << std::setprecision(1)
+           << avg << "ns avg, " << share << "% time, " << dmi << "% dmi";
+
+        if (c.debug)
+            os << ", " << c.debug << " debug";
+        if (c.errors)
+            os << ", " << c.errors << " errors";
+    }
+}
+
+} // namespace vcml
@@ -35,15 +35,26 @@ tlm_initiator_socket::tlm_initiator_socket(const char* nm,
     m_host(hierarchy_search<tlm_host>()),
     m_parent(hierarchy_search<module>()),
     m_adapter(nullptr),
+    m_profile(),
+    m_filter(),
     trace_all(this, "trace", false),
     trace_errors(this, "trace_errors", false),
-    allow_dmi(this, "allow_dmi", true) {
+    trace_rules(this, "trace_rules", ""),
+    allow_dmi(this, "allow_dmi", true),
+    profile(this, "profile", false),
+    profile_granule(this, "profile_granule", 4 * KiB) {
     VCML_ERROR_ON(!m_host, "socket '%s' declared outside tlm_host", nm);
     VCML_ERROR_ON(!m_parent, "socket '%s' declared outside module", nm);
 
     trace_all.inherit_default();
     trace_errors.inherit_default();
+    trace_rules.inherit_default();
     allow_dmi.inherit_default();
+    profile.inherit_default();
+    profile_granule.inherit_default();
+
+    m_profile.reset(new tlm_profile(profile_granule));
+    m_filter.configure(trace_rules);
 
     m_host->register_socket(this);
 
@@ -71,10 +82,10 @@ u8* tlm_initiator_socket::lookup_dmi_ptr(const range& mem, vcml_access rw) {
     if (dmi_cache().lookup(mem, rw, dmi))
         return dmi_get_ptr(dmi, mem.start);
 
-    tlm_generic_payload tx;
+    tlm_pooled_tx tx(m_host->tx_pool());
     tlm_command cmd = tlm_command_from_access(rw);
-    tx_setup(tx, cmd, mem.start, nullptr, mem.length());
-    if (!(*this)->get_direct_mem_ptr(tx, dmi))
+    tx_setup(*tx, cmd, mem.start, nullptr, mem.length());
+    if (!(*this)->get_direct_mem_ptr(*tx, dmi))
         return nullptr;
 
     map_dmi(dmi);
@@ -97,7 +108,13 @@ void tlm_initiator_socket::b_transport(tlm_generic_payload& tx, sc_time& t) {
 }
 
 unsigned int tlm_initiator_socket::send(tlm_generic_payload& tx,
-                                        const tlm_sbi& info) try {
+                                        const tlm_sbi& info) {
+    return do_send(tx, info, true);
+}
+
+unsigned int tlm_initiator_socket::do_send(tlm_generic_payload& tx,
+                                           const tlm_sbi& info,
+                                           bool trace) try {
     unsigned int bytes = 0;
     unsigned int size = tx.get_data_length();
     unsigned int width = tx.get_streaming_width();
@@ -118,6 +135,8 @@ unsigned int tlm_initiator_socket::send(tlm_generic_payload& tx,
     tx_reset(tx);
     tx_set_sbi(tx, m_sbi | info);
 
+    u64 host_start = profile ? tlm_profile::host_ns() : 0;
+
     if (info.is_debug) {
         sc_time t1(sc_time_stamp());
         bytes = (*this)->transport_dbg(tx);
@@ -135,7 +154,10 @@ unsigned int tlm_initiator_socket::send(tlm_generic_payload& tx,
         sc_time& offset = m_host->local_time();
         sc_time local = sc_time_stamp() + offset;
 
-        b_transport(tx, offset);
+        if (trace)
+            b_transport(tx, offset);
+        else
+            (*this)->b_transport(tx, offset);
 
         sc_time now = sc_time_stamp() + offset;
         VCML_ERROR_ON(now < local, "b_transport time went backwards");
@@ -148,6 +170,12 @@ unsigned int tlm_initiator_socket::send(tlm_generic_payload& tx,
     if (info.is_excl && !tx_is_excl(tx))
         bytes = 0;
 
+    if (profile) {
+        u64 host_ns = tlm_profile::host_ns() - host_start;
+        m_profile->record(addr, size, host_ns, false, info.is_debug,
+                          failed(tx));
+    }
+
     if (allow_dmi && tx.is_dmi_allowed()) {
         tlm_dmi dmi;
         tx.set_address(addr);
@@ -179,6 +207,8 @@ tlm_response_status tlm_initiator_socket::access_dmi(tlm_command cmd, u64 addr,
     if (info.is_sync && !info.is_debug)
         m_host->sync();
 
+    u64 host_start = profile ? tlm_profile::host_ns() : 0;
+
     sc_time latency = SC_ZERO_TIME;
     if (cmd == TLM_READ_COMMAND) {
         memcpy(data, dmi_get_ptr(dmi, addr), size);
@@ -188,6 +218,11 @@ tlm_response_status tlm_initiator_socket::access_dmi(tlm_command cmd, u64 addr,
         latency += dmi.get_write_latency();
     }
 
+    if (profile) {
+        u64 host_ns = tlm_profile::host_ns() - host_start;
+        m_profile->record(addr, size, host_ns, true, info.is_debug, false);
+    }
+
     if (!info.is_debug) {
         m_host->local_time() += latency;
         if (info.is_sync)
@@ -201,6 +236,21 @@ tlm_response_status tlm_initiator_socket::access(tlm_command cmd, u64 addr,
                                                  void* data, unsigned int size,
                                                  const tlm_sbi& info,
                                                  unsigned int* sz) {
+    // async threads may use DMI directly, but all other accesses need to be
+    // funneled through the SystemC thread to keep peripherals thread-safe
+    if (!info.is_debug && sc_is_async()) {
+        if (cmd != TLM_IGNORE_COMMAND && allow_dmi && !info.is_sync &&
+            success(access_dmi(cmd, addr, data, size, info))) {
+            if (sz != nullptr)
+                *sz = size;
+            return TLM_OK_RESPONSE;
+        }
+
+        tlm_response_status rs = TLM_INCOMPLETE_RESPONSE;
+        sc_sync([&]() { rs = access(cmd, addr, data, size, info, sz); });
+        return rs;
+    }
+
     // TLM protocol sanity checking
     if (!info.is_debug && !is_thread())
         VCML_ERROR("non-debug TLM access outside SC_THREAD forbidden");
@@ -233,6 +283,186 @@ tlm_response_status tlm_initiator_socket::access(tlm_command cmd, u64 addr,
     return rs;
 }
 
+static void gather(vector<u8>& buf, const tlm_iovec* iov, size_t count) {
+    u8* ptr = buf.data();
+    for (size_t i = 0; i < count; i++) {
+        memcpy(ptr, iov[i].data, iov[i].size);
+        ptr += iov[i].size;
+    }
+}
+
+tlm_response_status tlm_initiator_socket::access_vectored(
+    tlm_command cmd, const tlm_iovec* iov, size_t count, const tlm_sbi& info,
+    unsigned int* nbytes) {
+    // async threads may use DMI directly, but the first piece that needs a
+    // regular transaction hands the rest of the batch to the SystemC thread
+    if (!info.is_debug && sc_is_async()) {
+        unsigned int total = 0;
+        size_t done = 0;
+
+        if (cmd != TLM_IGNORE_COMMAND && allow_dmi && !info.is_sync) {
+            for (; done < count; done++) {
+                const tlm_iovec& v = iov[done];
+                if (!success(access_dmi(cmd, v.addr, v.data, v.size, info)))
+                    break;
+                total += v.size;
+            }
+        }
+
+        tlm_response_status rs = TLM_OK_RESPONSE;
+        if (done < count) {
+            unsigned int n = 0;
+            sc_sync([&]() {
+                rs = access_vectored(cmd, iov + done, count - done, info, &n);
+            });
+            total += n;
+        }
+
+        if (nbytes != nullptr)
+            *nbytes = total;
+        return rs;
+    }
+
+    // TLM protocol sanity checking
+    if (!info.is_debug && !is_thread())
+        VCML_ERROR("non-debug TLM access outside SC_THREAD forbidden");
+
+    bool use_dmi = cmd != TLM_IGNORE_COMMAND && allow_dmi && !info.is_nodmi &&
+                   !info.is_excl;
+    tlm_command elevate = info.is_debug ? TLM_READ_COMMAND : cmd;
+    vcml_access rwx = tlm_command_to_access(elevate);
+
+    if (info.is_sync && !info.is_debug)
+        m_host->sync();
+
+    // the batch is traced once per run of pieces that are contiguous in
+    // the address space instead of once per piece, so the trace only shows
+    // addresses that were actually accessed
+    struct trace_run {
+        u64 addr;
+        size_t offset;
+        size_t length;
+    };
+
+    bool trace = !info.is_debug && count > 0 && (trace_all || trace_errors);
+    tlm_generic_payload batch;
+    vector<u8> batch_data;
+    vector<trace_run> runs;
+    if (trace) {
+        size_t length = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (runs.empty() ||
+                runs.back().addr + runs.back().length != iov[i].addr) {
+                runs.push_back({ iov[i].addr, length, 0 });
+            }
+
+            runs.back().length += iov[i].size;
+            length += iov[i].size;
+        }
+
+        batch_data.resize(length);
+        if (cmd == TLM_WRITE_COMMAND)
+            gather(batch_data, iov, count);
+
+        for (const trace_run& run : runs) {
+            tx_setup(batch, cmd, run.addr, batch_data.data() + run.offset,
+                     run.length);
+            trace_fw(batch, m_host->local_time());
+        }
+    }
+
+    tlm_response_status rs = TLM_OK_RESPONSE;
+    sc_time latency = SC_ZERO_TIME;
+    unsigned int total = 0;
+    bool have_dmi = false;
+    tlm_dmi dmi;
+
+    for (size_t i = 0; i < count && success(rs); i++) {
+        u64 addr = iov[i].addr;
+        u8* data = (u8*)iov[i].data;
+        unsigned int size = iov[i].size;
+
+        while (size > 0) {
+            // resolve DMI only once per contiguous region
+            if (use_dmi && (!have_dmi || addr < dmi.get_start_address() ||
+                            addr > dmi.get_end_address())) {
+                have_dmi = dmi_cache().lookup(range(addr, addr), rwx, dmi);
+            }
+
+            if (use_dmi && have_dmi) {
+                u64 end = dmi.get_end_address();
+                unsigned int n = end - addr >= size - 1 ? size
+                                                        : end - addr + 1;
+                u64 host_start = profile ? tlm_profile::host_ns() : 0;
+                if (cmd == TLM_READ_COMMAND) {
+                    memcpy(data, dmi_get_ptr(dmi, addr), n);
+                    latency += dmi.get_read_latency();
+                } else if (cmd == TLM_WRITE_COMMAND) {
+                    memcpy(dmi_get_ptr(dmi, addr), data, n);
+                    latency += dmi.get_write_latency();
+                }
+
+                if (profile) {
+                    u64 host_ns = tlm_profile::host_ns() - host_start;
+                    m_profile->record(addr, n, host_ns, true, info.is_debug,
+                                      false);
+                }
+
+                addr += n;
+                data += n;
+                size -= n;
+                total += n;
+                continue;
+            }
+
+            // non-DMI piece: charge accumulated latency before transport
+            if (!info.is_debug) {
+                m_host->local_time() += latency;
+                latency = SC_ZERO_TIME;
+            }
+
+            auto& tx = info.is_debug ? m_txd : m_tx;
+            tx_setup(tx, cmd, addr, data, size);
+            total += do_send(tx, info, false);
+            have_dmi = false;
+
+            // transport_dbg does not always change response status
+            rs = tx.get_response_status();
+            if (rs == TLM_INCOMPLETE_RESPONSE && info.is_debug)
+                rs = TLM_OK_RESPONSE;
+
+            if (rs == TLM_INCOMPLETE_RESPONSE)
+                m_parent->log_warn("got incomplete response from 0x%016llx",
+                                   addr);
+            break;
+        }
+    }
+
+    if (!info.is_debug) {
+        m_host->local_time() += latency;
+
+        if (trace) {
+            if (cmd == TLM_READ_COMMAND)
+                gather(batch_data, iov, count);
+
+            for (const trace_run& run : runs) {
+                tx_setup(batch, cmd, run.addr,
+                         batch_data.data() + run.offset, run.length);
+                batch.set_response_status(rs);
+                trace_bw(batch, m_host->local_time());
+            }
+        }
+
+        if (info.is_sync || m_host->needs_sync())
+            m_host->sync();
+    }
+
+    if (nbytes != nullptr)
+        *nbytes = total;
+
+    return rs;
+}
+
 void tlm_initiator_socket::stub(tlm_response_status r) {
     VCML_ERROR_ON(m_stub, "socket %s already stubbed", name());
     auto guard = get_hierarchy_scope();
@@ -275,11 +505,16 @@ void tlm_target_socket::b_transport(tlm_generic_payload& tx, sc_time& dt) {
         }
     }
 
+    u64 host_start = profile ? tlm_profile::host_ns() : 0;
+
     if (m_exmon.update(tx))
         m_host->b_transport(*this, tx, dt);
     else
         tx.set_response_status(TLM_OK_RESPONSE);
 
+    if (profile)
+        m_profile->record(tx, tlm_profile::host_ns() - host_start, false);
+
     m_curr++;
     if (m_free_ev)
         m_free_ev->notify();
@@ -294,7 +529,10 @@ unsigned int tlm_target_socket::transport_dbg(tlm_generic_payload& tx) {
     m_payload = &tx;
     m_sideband = tx_get_sbi(tx) | SBI_DEBUG;
 
+    u64 host_start = profile ? tlm_profile::host_ns() : 0;
     unsigned int n = m_host->transport_dbg(*this, tx);
+    if (profile)
+        m_profile->record(tx, tlm_profile::host_ns() - host_start, true);
 
     m_payload = nullptr;
     m_sideband = SBI_NONE;
@@ -331,15 +569,26 @@ tlm_target_socket::tlm_target_socket(const char* nm, address_space a):
     m_adapter(nullptr),
     m_payload(nullptr),
     m_sideband(SBI_NONE),
+    m_profile(),
+    m_filter(),
     trace_all(this, "trace", false),
     trace_errors(this, "trace_errors", false),
+    trace_rules(this, "trace_rules", ""),
     allow_dmi(this, "allow_dmi", true),
+    profile(this, "profile", false),
+    profile_granule(this, "profile_granule", 4 * KiB),
     as(a) {
     VCML_ERROR_ON(!m_host, "socket '%s' declared outside module", nm);
 
     trace_all.inherit_default();
     trace_errors.inherit_default();
+    trace_rules.inherit_default();
     allow_dmi.inherit_default();
+    profile.inherit_default();
+    profile_granule.inherit_default();
+
+    m_profile.reset(new tlm_profile(profile_granule));
+    m_filter.configure(trace_rules);
 
     m_host->register_socket(this);
 
@@ -0,0 +1,170 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/tracing/trace_filter.h"
+
+namespace vcml {
+
+enum : u32 {
+    ALL_PROTOCOLS = (1u << NUM_PROTOCOLS) - 1,
+    ALL_COMMANDS = (1u << TLM_READ_COMMAND) | (1u << TLM_WRITE_COMMAND) |
+                   (1u << TLM_IGNORE_COMMAND),
+};
+
+static u32 parse_protocols(const string& val) {
+    u32 mask = 0;
+    for (const string& name : split(val, ',')) {
+        int kind = 0;
+        for (; kind < NUM_PROTOCOLS; kind++) {
+            if (to_lower(protocol_name((protocol_kind)kind)) == to_lower(name))
+                break;
+        }
+
+        VCML_ERROR_ON(kind == NUM_PROTOCOLS, "unknown protocol: %s",
+                      name.c_str());
+        mask |= 1u << kind;
+    }
+
+    return mask;
+}
+
+static u32 parse_commands(const string& val) {
+    u32 mask = 0;
+    for (string cmd : split(val, ',')) {
+        cmd = to_lower(cmd);
+        if (cmd == "read" || cmd == "rd")
+            mask |= 1u << TLM_READ_COMMAND;
+        else if (cmd == "write" || cmd == "wr")
+            mask |= 1u << TLM_WRITE_COMMAND;
+        else if (cmd == "ignore" || cmd == "ig")
+            mask |= 1u << TLM_IGNORE_COMMAND;
+        else
+            VCML_ERROR("unknown command: %s", cmd.c_str());
+    }
+
+    return mask;
+}
+
+static range parse_range(const string& val) {
+    range r;
+    istringstream ss(val);
+    VCML_ERROR_ON(!(ss >> r), "invalid address range: %s", val.c_str());
+    return r;
+}
+
+bool trace_filter::accept_tlm(const tlm_generic_payload& tx) const {
+    if (!(m_commands & (1u << tx.get_command())))
+        return false;
+
+    if (m_addresses.empty())
+        return true;
+
+    range addr(tx);
+    for (const range& r : m_addresses)
+        if (r.overlaps(addr))
+            return true;
+
+    return false;
+}
+
+bool trace_filter::accept_sample(trace_direction dir) const {
+    // backward traces follow the decision of their forward trace
+    if (is_forward_trace(dir) || m_errors)
+        m_sampled = (m_counter++ % m_sample) == 0;
+    return m_sampled;
+}
+
+trace_filter::trace_filter():
+    m_active(false),
+    m_errors(false),
+    m_windowed(false),
+    m_protocols(ALL_PROTOCOLS),
+    m_commands(ALL_COMMANDS),
+    m_sample(1),
+    m_start(SC_ZERO_TIME),
+    m_stop(SC_ZERO_TIME),
+    m_addresses(),
+    m_counter(0),
+    m_sampled(true) {
+}
+
+trace_filter::trace_filter(const string& spec): trace_filter() {
+    configure(spec);
+}
+
+void trace_filter::configure(const string& spec) {
+    clear();
+
+    u32 protocols = 0;
+    u32 commands = 0;
+
+    for (string token : split(spec, ' ')) {
+        token = trim(token);
+        if (token.empty())
+            continue;
+
+        size_t pos = token.find(':');
+        string key = to_lower(token.substr(0, pos));
+        string val = pos == string::npos ? "" : token.substr(pos + 1);
+
+        if (key == "proto" || key == "protocol") {
+            protocols |= parse_protocols(val);
+        } else if (key == "addr" || key == "address") {
+            for (const string& r : split(val, ','))
+                m_addresses.push_back(parse_range(r));
+        } else if (key == "cmd" || key == "command") {
+            commands |= parse_commands(val);
+        } else if (key == "errors") {
+            m_errors = true;
+        } else if (key == "sample") {
+            m_sample = from_string<u64>(val);
+            VCML_ERROR_ON(m_sample == 0, "invalid sample rate: %s",
+                          val.c_str());
+        } else if (key == "time") {
+            size_t sep = val.find("..");
+            VCML_ERROR_ON(sep == string::npos, "invalid time window: %s",
+                          val.c_str());
+            string start = val.substr(0, sep);
+            string stop = val.substr(sep + 2);
+            m_start = SC_ZERO_TIME;
+            m_stop = sc_core::sc_max_time();
+            if (!start.empty())
+                m_start = from_string<sc_time>(start);
+            if (!stop.empty())
+                m_stop = from_string<sc_time>(stop);
+            m_windowed = true;
+        } else {
+            VCML_ERROR("unknown trace filter: %s", token.c_str());
+        }
+
+        m_active = true;
+    }
+
+    if (protocols)
+        m_protocols = protocols;
+    if (commands)
+        m_commands = commands;
+}
+
+void trace_filter::clear() {
+    m_active = false;
+    m_errors = false;
+    m_windowed = false;
+    m_protocols = ALL_PROTOCOLS;
+    m_commands = ALL_COMMANDS;
+    m_sample = 1;
+    m_start = SC_ZERO_TIME;
+    m_stop = SC_ZERO_TIME;
+    m_addresses.clear();
+    m_counter = 0;
+    m_sampled = true;
+}
+
+} // namespace vcml
@@ -43,7 +43,11 @@ const char* protocol_name(protocol_kind kind) {
     }
 }
 
-tracer::tracer(): m_mtx() {
+tracer::tracer(): tracer(true) {
+    // nothing to do
+}
+
+tracer::tracer(bool serialize): m_mtx(), m_serialize(serialize) {
     all().insert(this);
 }
 
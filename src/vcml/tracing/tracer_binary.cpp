@@ -0,0 +1,722 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/protocols/tlm.h"
+#include "vcml/protocols/gpio.h"
+#include "vcml/protocols/clk.h"
+#include "vcml/protocols/sd.h"
+#include "vcml/protocols/spi.h"
+#include "vcml/protocols/i2c.h"
+#include "vcml/protocols/pci.h"
+#include "vcml/protocols/eth.h"
+#include "vcml/protocols/can.h"
+#include "vcml/protocols/usb.h"
+#include "vcml/protocols/serial.h"
+#include "vcml/protocols/virtio.h"
+
+#include "vcml/tracing/tracer_binary.h"
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace vcml {
+
+enum : u32 {
+    FILE_VERSION = 2,
+    BLOCK_MAGIC = 0x4b4c4256, // "VBLK"
+};
+
+enum block_type : u32 {
+    BLOCK_NAMES = 1,
+    BLOCK_DATA = 2,
+    BLOCK_INDEX = 3,
+};
+
+enum block_compression : u32 {
+    COMPRESS_NONE = 0,
+    COMPRESS_ZLIB = 1,
+};
+
+enum record_format : u8 {
+    FORMAT_TEXT = 0,
+    FORMAT_TLM = 1,
+    FORMAT_GPIO = 2,
+    FORMAT_CLK = 3,
+    FORMAT_PCI = 4,
+    FORMAT_I2C = 5,
+    FORMAT_SPI = 6,
+    FORMAT_SD_COMMAND = 7,
+    FORMAT_SD_DATA = 8,
+    FORMAT_SERIAL = 9,
+    FORMAT_CAN = 10,
+};
+
+// Payloads without pointers are stored as a plain copy of their structure
+// and only formatted when converting. All others are stored as text.
+template <typename PAYLOAD>
+struct raw_format {
+    static constexpr record_format FORMAT = FORMAT_TEXT;
+};
+
+#define VCML_RAW_FORMAT(payload, format)                                   \
+    template <>                                                            \
+    struct raw_format<payload> {                                           \
+        static constexpr record_format FORMAT = format;                    \
+    }
+
+VCML_RAW_FORMAT(gpio_payload, FORMAT_GPIO);
+VCML_RAW_FORMAT(clk_payload, FORMAT_CLK);
+VCML_RAW_FORMAT(pci_payload, FORMAT_PCI);
+VCML_RAW_FORMAT(i2c_payload, FORMAT_I2C);
+VCML_RAW_FORMAT(spi_payload, FORMAT_SPI);
+VCML_RAW_FORMAT(sd_command, FORMAT_SD_COMMAND);
+VCML_RAW_FORMAT(sd_data, FORMAT_SD_DATA);
+VCML_RAW_FORMAT(serial_payload, FORMAT_SERIAL);
+VCML_RAW_FORMAT(can_frame, FORMAT_CAN);
+
+#undef VCML_RAW_FORMAT
+
+struct file_header {
+    char magic[8];
+    u32 version;
+    u32 flags;
+};
+
+struct file_footer {
+    u64 index_offset;
+    char magic[8];
+};
+
+struct block_header {
+    u32 magic;
+    u32 type;
+    u64 raw_size;
+    u64 stored_size;
+    u64 first_time;
+    u64 last_time;
+    u64 count;
+    u32 compression;
+    u32 reserved;
+};
+
+struct index_entry {
+    u64 offset;
+    u64 first_time;
+    u64 last_time;
+    u64 count;
+};
+
+struct record_header {
+    u32 size;
+    u32 port;
+    u64 time;
+    u64 delta;
+    u8 kind;
+    i8 dir;
+    u8 error;
+    u8 format;
+    u32 reserved;
+};
+
+struct record_tlm {
+    u64 address;
+    u32 length;
+    u8 command;
+    i8 response;
+    u16 reserved;
+};
+
+static const char FILE_MAGIC[8] = "VCMLTRC";
+static const char INDEX_MAGIC[8] = "VCMLIDX";
+
+static void append(vector<u8>& buf, const void* data, size_t size) {
+    const u8* ptr = (const u8*)data;
+    buf.insert(buf.end(), ptr, ptr + size);
+}
+
+static u64 next_tracer_id() {
+    static atomic<u64> id(0);
+    return ++id;
+}
+
+class tracer_binary::ring
+{
+public:
+    vector<u8> buffer;
+    atomic<size_t> head;
+    atomic<size_t> tail;
+
+    // only accessed from the thread owning this ring
+    unordered_map<const sc_object*, u32> ports;
+    vector<u8> scratch;
+
+    ring(): buffer(RING_SIZE), head(0), tail(0), ports(), scratch() {}
+
+    size_t used() const {
+        return head.load(std::memory_order_relaxed) -
+               tail.load(std::memory_order_relaxed);
+    }
+
+    bool push(const u8* data, size_t size) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        if (RING_SIZE - (h - t) < size)
+            return false;
+
+        size_t off = h % RING_SIZE;
+        size_t n = min<size_t>(size, RING_SIZE - off);
+        memcpy(buffer.data() + off, data, n);
+        memcpy(buffer.data(), data + n, size - n);
+        head.store(h + size, std::memory_order_release);
+        return true;
+    }
+
+    size_t drain(vector<u8>& out) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_acquire);
+        size_t size = h - t;
+        if (size == 0)
+            return 0;
+
+        size_t pos = out.size();
+        out.resize(pos + size);
+
+        size_t off = t % RING_SIZE;
+        size_t n = min<size_t>(size, RING_SIZE - off);
+        memcpy(out.data() + pos, buffer.data() + off, n);
+        memcpy(out.data() + pos + n, buffer.data(), size - n);
+        tail.store(h, std::memory_order_release);
+        return size;
+    }
+};
+
+tracer_binary::ring& tracer_binary::local_ring() {
+    thread_local u64 last_id = 0;
+    thread_local ring* last_ring = nullptr;
+    if (last_id == m_id)
+        return *last_ring;
+
+    // tracer ids are never reused, so stale entries cannot alias
+    thread_local unordered_map<u64, ring*> rings;
+    ring*& r = rings[m_id];
+    if (r == nullptr) {
+        lock_guard<mutex> guard(m_rings_mtx);
+        m_rings.push_back(std::make_unique<ring>());
+        r = m_rings.back().get();
+    }
+
+    last_id = m_id;
+    last_ring = r;
+    return *r;
+}
+
+u32 tracer_binary::port_id(ring& r, const sc_object& port) {
+    auto it = r.ports.find(&port);
+    if (it != r.ports.end())
+        return it->second;
+
+    lock_guard<mutex> guard(m_ports_mtx);
+    string name = port.name();
+    auto [entry, inserted] = m_ports.emplace(name, (u32)m_ports.size());
+    if (inserted)
+        m_names.emplace_back(entry->second, name);
+    r.ports[&port] = entry->second;
+    return entry->second;
+}
+
+template <typename PAYLOAD>
+void tracer_binary::store(const activity<PAYLOAD>& msg) {
+    if (m_failed.load(std::memory_order_relaxed)) {
+        m_dropped++;
+        return;
+    }
+
+    ring& r = local_ring();
+
+    record_header hdr{};
+    hdr.port = port_id(r, msg.port);
+    hdr.time = time_to_ps(msg.t);
+    hdr.delta = msg.cycle;
+    hdr.kind = (u8)msg.kind;
+    hdr.dir = (i8)msg.dir;
+    hdr.error = msg.error ? 1 : 0;
+
+    vector<u8>& buf = r.scratch;
+    buf.resize(sizeof(hdr));
+
+    if constexpr (std::is_same_v<PAYLOAD, tlm_generic_payload>) {
+        const tlm_generic_payload& tx = msg.payload;
+        const u8* data = tx.get_data_ptr();
+        size_t limit = MAX_RECORD - sizeof(hdr) - sizeof(record_tlm);
+
+        record_tlm body{};
+        body.address = tx.get_address();
+        body.length = data ? min<size_t>(tx.get_data_length(), limit) : 0;
+        body.command = (u8)tx.get_command();
+        body.response = (i8)tx.get_response_status();
+
+        hdr.format = FORMAT_TLM;
+        append(buf, &body, sizeof(body));
+        append(buf, data, body.length);
+    } else if constexpr (raw_format<PAYLOAD>::FORMAT != FORMAT_TEXT) {
+        static_assert(std::is_trivially_copyable_v<PAYLOAD>,
+                      "raw records require trivially copyable payloads");
+        hdr.format = raw_format<PAYLOAD>::FORMAT;
+        append(buf, &msg.payload, sizeof(PAYLOAD));
+    } else {
+        string text = to_string(msg.payload);
+        size_t length = min<size_t>(text.length(), MAX_RECORD - sizeof(hdr));
+
+        hdr.format = FORMAT_TEXT;
+        append(buf, text.data(), length);
+    }
+
+    hdr.size = (u32)buf.size();
+    memcpy(buf.data(), &hdr, sizeof(hdr));
+
+    // never drop records while the file is healthy: wait for the writer
+    // to make room instead
+    while (!r.push(buf.data(), buf.size())) {
+        if (!m_running) {
+            flush();
+            continue;
+        }
+
+        kick();
+        std::this_thread::yield();
+    }
+
+    if (r.used() > RING_SIZE / 2)
+        kick();
+}
+
+void tracer_binary::kick() {
+    if (m_kicked.load(std::memory_order_relaxed))
+        return;
+
+    if (!m_kicked.exchange(true)) {
+        lock_guard<mutex> guard(m_wake_mtx);
+        m_wake.notify_one();
+    }
+}
+
+void tracer_binary::writer() {
+    mwr::set_thread_name("vcml_trace");
+
+    while (m_running) {
+        std::unique_lock<mutex> lock(m_wake_mtx);
+        m_wake.wait_for(lock, std::chrono::milliseconds(10),
+                        [&]() -> bool { return m_kicked || !m_running; });
+        lock.unlock();
+
+        m_kicked = false;
+        flush();
+    }
+}
+
+void tracer_binary::fail() {
+    // this runs on the writer thread or in the destructor, so throwing
+    // would terminate the simulation
+    if (!m_failed.exchange(true)) {
+        log_error("failed to write %s, dropping trace records",
+                  m_filename.c_str());
+    }
+}
+
+bool tracer_binary::write_block(u32 type, const vector<u8>& data, u64 count,
+                                u64 first, u64 last) {
+    if (m_failed)
+        return false;
+
+    block_header hdr{};
+    hdr.magic = BLOCK_MAGIC;
+    hdr.type = type;
+    hdr.raw_size = data.size();
+    hdr.first_time = first;
+    hdr.last_time = last;
+    hdr.count = count;
+    hdr.compression = COMPRESS_NONE;
+
+    const u8* ptr = data.data();
+    size_t size = data.size();
+
+#ifdef HAVE_ZLIB
+    uLongf packed = compressBound(size);
+    m_packed.resize(packed);
+    if (compress2(m_packed.data(), &packed, ptr, size, Z_BEST_SPEED) == Z_OK &&
+        packed < size) {
+        hdr.compression = COMPRESS_ZLIB;
+        ptr = m_packed.data();
+        size = packed;
+    }
+#endif
+
+    hdr.stored_size = size;
+    m_stream.write((const char*)&hdr, sizeof(hdr));
+    m_stream.write((const char*)ptr, size);
+    m_stream.flush();
+    if (!m_stream) {
+        fail();
+        return false;
+    }
+
+    m_offset += sizeof(hdr) + size;
+    m_bytes = m_offset;
+    return true;
+}
+
+void tracer_binary::write_names() {
+    vector<pair<u32, string>> names;
+    {
+        lock_guard<mutex> guard(m_ports_mtx);
+        names.swap(m_names);
+    }
+
+    if (names.empty())
+        return;
+
+    vector<u8> data;
+    for (const auto& [id, name] : names) {
+        u32 length = (u32)name.length();
+        append(data, &id, sizeof(id));
+        append(data, &length, sizeof(length));
+        append(data, name.data(), length);
+    }
+
+    write_block(BLOCK_NAMES, data, names.size());
+}
+
+void tracer_binary::write_data() {
+    if (m_block.empty())
+        return;
+
+    // ports get registered before their first record is pushed, so all
+    // names referenced by this block are known at this point
+    write_names();
+
+    u64 count = 0;
+    u64 first = ~0ull;
+    u64 last = 0;
+    for (size_t pos = 0; pos < m_block.size(); count++) {
+        record_header hdr;
+        memcpy(&hdr, m_block.data() + pos, sizeof(hdr));
+        first = min(first, hdr.time);
+        last = max(last, hdr.time);
+        pos += hdr.size;
+    }
+
+    index_entry entry{ m_offset, first, last, count };
+    if (write_block(BLOCK_DATA, m_block, count, first, last)) {
+        append(m_index, &entry, sizeof(entry));
+        m_records += count;
+    } else {
+        m_dropped += count;
+    }
+
+    m_block.clear();
+}
+
+void tracer_binary::flush() {
+    lock_guard<mutex> guard(m_write_mtx);
+
+    vector<ring*> rings;
+    {
+        lock_guard<mutex> rguard(m_rings_mtx);
+        for (auto& r : m_rings)
+            rings.push_back(r.get());
+    }
+
+    for (ring* r : rings) {
+        r->drain(m_block);
+        if (m_block.size() >= BLOCK_SIZE)
+            write_data();
+    }
+
+    write_data();
+}
+
+void tracer_binary::trace(const activity<tlm_generic_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<gpio_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<clk_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<pci_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<i2c_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<spi_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<sd_command>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<sd_data>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<vq_message>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<serial_payload>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<eth_frame>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<can_frame>& msg) {
+    store(msg);
+}
+
+void tracer_binary::trace(const activity<usb_packet>& msg) {
+    store(msg);
+}
+
+tracer_binary::tracer_binary(const string& file):
+    tracer(false),
+    m_id(next_tracer_id()),
+    m_filename(file),
+    m_stream(m_filename.c_str(), std::ios::binary),
+    m_offset(0),
+    m_rings_mtx(),
+    m_rings(),
+    m_ports_mtx(),
+    m_ports(),
+    m_names(),
+    m_write_mtx(),
+    m_block(),
+    m_packed(),
+    m_index(),
+    m_records(0),
+    m_dropped(0),
+    m_bytes(0),
+    m_failed(false),
+    m_wake_mtx(),
+    m_wake(),
+    m_kicked(false),
+    m_running(true),
+    m_writer() {
+    VCML_ERROR_ON(!m_stream.is_open(), "failed to open %s", file.c_str());
+
+    file_header hdr{};
+    memcpy(hdr.magic, FILE_MAGIC, sizeof(hdr.magic));
+    hdr.version = FILE_VERSION;
+    m_stream.write((const char*)&hdr, sizeof(hdr));
+    m_offset = sizeof(hdr);
+
+    m_block.reserve(2 * BLOCK_SIZE);
+    m_writer = thread(&tracer_binary::writer, this);
+}
+
+tracer_binary::~tracer_binary() {
+    m_running = false;
+    {
+        lock_guard<mutex> guard(m_wake_mtx);
+        m_wake.notify_all();
+    }
+
+    if (m_writer.joinable())
+        m_writer.join();
+
+    flush();
+
+    lock_guard<mutex> guard(m_write_mtx);
+    file_footer footer{};
+    footer.index_offset = m_offset;
+    memcpy(footer.magic, INDEX_MAGIC, sizeof(footer.magic));
+    size_t count = m_index.size() / sizeof(index_entry);
+    if (write_block(BLOCK_INDEX, m_index, count)) {
+        m_stream.write((const char*)&footer, sizeof(footer));
+        m_stream.flush();
+        if (!m_stream)
+            fail();
+    }
+
+    if (m_dropped > 0) {
+        log_warn("%s: dropped %llu trace records", m_filename.c_str(),
+                 (unsigned long long)m_dropped);
+    }
+}
+
+static void unpack(const string& file, const block_header& hdr,
+                   vector<u8>& stored, vector<u8>& raw) {
+    switch (hdr.compression) {
+    case COMPRESS_NONE:
+        raw.swap(stored);
+        break;
+
+    case COMPRESS_ZLIB: {
+#ifdef HAVE_ZLIB
+        uLongf size = hdr.raw_size;
+        raw.resize(size);
+        int res = uncompress(raw.data(), &size, stored.data(), stored.size());
+        VCML_ERROR_ON(res != Z_OK || size != hdr.raw_size,
+                      "%s: failed to decompress block", file.c_str());
+#else
+        VCML_ERROR("%s: zlib support not available", file.c_str());
+#endif
+        break;
+    }
+
+    default:
+        VCML_ERROR("%s: unknown compression %u", file.c_str(),
+                   hdr.compression);
+    }
+}
+
+template <typename PAYLOAD>
+static string raw_to_string(const record_header& hdr, const u8* body) {
+    if (hdr.size != sizeof(hdr) + sizeof(PAYLOAD))
+        VCML_ERROR("corrupt %s record", protocol_name(protocol<PAYLOAD>::KIND));
+
+    alignas(PAYLOAD) u8 storage[sizeof(PAYLOAD)];
+    memcpy(storage, body, sizeof(storage));
+    return to_string(*(const PAYLOAD*)storage);
+}
+
+static void print_record(ostream& os, const record_header& hdr,
+                         const u8* body, const string& port) {
+    string text;
+    switch (hdr.format) {
+    case FORMAT_TLM: {
+        record_tlm tlm;
+        memcpy(&tlm, body, sizeof(tlm));
+
+        tlm_generic_payload tx;
+        tx.set_command((tlm_command)tlm.command);
+        tx.set_address(tlm.address);
+        tx.set_data_ptr(const_cast<u8*>(body + sizeof(tlm)));
+        tx.set_data_length(tlm.length);
+        tx.set_response_status((tlm_response_status)tlm.response);
+        text = tlm_transaction_to_str(tx);
+        break;
+    }
+
+    case FORMAT_GPIO:
+        text = raw_to_string<gpio_payload>(hdr, body);
+        break;
+    case FORMAT_CLK:
+        text = raw_to_string<clk_payload>(hdr, body);
+        break;
+    case FORMAT_PCI:
+        text = raw_to_string<pci_payload>(hdr, body);
+        break;
+    case FORMAT_I2C:
+        text = raw_to_string<i2c_payload>(hdr, body);
+        break;
+    case FORMAT_SPI:
+        text = raw_to_string<spi_payload>(hdr, body);
+        break;
+    case FORMAT_SD_COMMAND:
+        text = raw_to_string<sd_command>(hdr, body);
+        break;
+    case FORMAT_SD_DATA:
+        text = raw_to_string<sd_data>(hdr, body);
+        break;
+    case FORMAT_SERIAL:
+        text = raw_to_string<serial_payload>(hdr, body);
+        break;
+    case FORMAT_CAN:
+        text = raw_to_string<can_frame>(hdr, body);
+        break;
+
+    default:
+        text = string((const char*)body, hdr.size - sizeof(hdr));
+        break;
+    }
+
+    // same layout as tracer_file
+    vector<string> lines = split(escape(text), '\n');
+    for (const string& line : lines) {
+        os << "[" << protocol_name((protocol_kind)hdr.kind);
+        mwr::publisher::print_timing(os, hdr.time / 1000);
+        os << "] " << port;
+
+        if (is_forward_trace((trace_direction)hdr.dir))
+            os << " >> ";
+
+        if (is_backward_trace((trace_direction)hdr.dir))
+            os << " << ";
+
+        os << line << "\n";
+    }
+}
+
+void tracer_binary::convert(const string& file, ostream& os) {
+    ifstream is(file.c_str(), std::ios::binary);
+    VCML_ERROR_ON(!is.is_open(), "failed to open %s", file.c_str());
+
+    file_header fhdr;
+    is.read((char*)&fhdr, sizeof(fhdr));
+    VCML_ERROR_ON(!is || memcmp(fhdr.magic, FILE_MAGIC, sizeof(FILE_MAGIC)),
+                  "%s: not a binary trace file", file.c_str());
+    VCML_ERROR_ON(fhdr.version == 0 || fhdr.version > FILE_VERSION,
+                  "%s: unsupported version %u", file.c_str(), fhdr.version);
+
+    unordered_map<u32, string> names;
+    vector<u8> stored, raw;
+
+    block_header hdr;
+    while (is.read((char*)&hdr, sizeof(hdr))) {
+        VCML_ERROR_ON(hdr.magic != BLOCK_MAGIC, "%s: corrupt block",
+                      file.c_str());
+
+        stored.resize(hdr.stored_size);
+        is.read((char*)stored.data(), stored.size());
+        VCML_ERROR_ON(!is, "%s: truncated block", file.c_str());
+
+        if (hdr.type == BLOCK_INDEX)
+            break;
+
+        unpack(file, hdr, stored, raw);
+
+        for (size_t pos = 0; pos < raw.size();) {
+            if (hdr.type == BLOCK_NAMES) {
+                u32 id, length;
+                memcpy(&id, raw.data() + pos, sizeof(id));
+                memcpy(&length, raw.data() + pos + 4, sizeof(length));
+                names[id] = string((const char*)raw.data() + pos + 8, length);
+                pos += 8 + length;
+                continue;
+            }
+
+            record_header rec;
+            memcpy(&rec, raw.data() + pos, sizeof(rec));
+            VCML_ERROR_ON(rec.size < sizeof(rec) ||
+                              pos + rec.size > raw.size(),
+                          "%s: corrupt record", file.c_str());
+
+            auto it = names.find(rec.port);
+            string port = it != names.end() ? it->second : "<unknown>";
+            print_record(os, rec, raw.data() + pos + sizeof(rec), port);
+            pos += rec.size;
+        }
+    }
+
+    os.flush();
+}
+
+} // namespace vcml
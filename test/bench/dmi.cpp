@@ -0,0 +1,84 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+// reference implementation of the previous mutex protected linear cache
+class dmi_cache_linear
+{
+private:
+    std::mutex m_mtx;
+    std::vector<tlm::tlm_dmi> m_entries;
+
+public:
+    void insert(const tlm::tlm_dmi& dmi) {
+        std::lock_guard<std::mutex> guard(m_mtx);
+        m_entries.insert(m_entries.begin(), dmi);
+    }
+
+    bool lookup(const vcml::range& r, vcml::vcml_access rwx,
+                tlm::tlm_dmi& out) {
+        std::lock_guard<std::mutex> guard(m_mtx);
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (r.inside(m_entries[i]) &&
+                vcml::dmi_check_access(m_entries[i], rwx)) {
+                std::swap(m_entries[i], m_entries[0]);
+                out = m_entries[0];
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
+template <typename CACHE>
+static double dmi_benchmark(CACHE& cache, size_t entries, size_t stride) {
+    const size_t lookups = 500000;
+    const vcml::u64 size = 0x1000;
+    static unsigned char dummy[0x1000];
+
+    for (size_t i = 0; i < entries; i++) {
+        tlm::tlm_dmi dmi;
+        dmi.allow_read_write();
+        dmi.set_start_address(i * 2 * size);
+        dmi.set_end_address(i * 2 * size + size - 1);
+        dmi.set_dmi_ptr(dummy + i * 64);
+        cache.insert(dmi);
+    }
+
+    size_t hits = 0;
+    tlm::tlm_dmi dmi;
+    vcml::u64 start = mwr::timestamp_us();
+    for (size_t i = 0; i < lookups; i++) {
+        vcml::u64 addr = ((i / stride) % entries) * 2 * size + (i % 64) * 4;
+        vcml::range r(addr, addr + 3);
+        hits += cache.lookup(r, vcml::VCML_ACCESS_READ, dmi) ? 1 : 0;
+    }
+
+    vcml::u64 duration = std::max<vcml::u64>(mwr::timestamp_us() - start, 1);
+    EXPECT_EQ(hits, lookups);
+    return lookups * 1e6 / duration;
+}
+
+TEST(dmi, benchmark) {
+    for (size_t entries : { 1, 4, 16 }) {
+        for (size_t stride : { 1, 64 }) {
+            vcml::tlm_dmi_cache cache;
+            dmi_cache_linear linear;
+            double lps_cache = dmi_benchmark(cache, entries, stride);
+            double lps_linear = dmi_benchmark(linear, entries, stride);
+            std::cout << entries << " entries, stride " << stride << ": "
+                      << std::fixed << std::setprecision(1)
+                      << lps_cache / 1e6 << "M lookups/s (linear: "
+                      << lps_linear / 1e6 << "M lookups/s)" << std::endl;
+        }
+    }
+}
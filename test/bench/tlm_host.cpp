@@ -0,0 +1,99 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class regbank : public peripheral
+{
+public:
+    enum : size_t { NUM_REGS = 256 };
+
+    vector<unique_ptr<reg<u32>>> regs;
+    tlm_target_socket in;
+
+    regbank(const sc_module_name& nm): peripheral(nm), regs(), in("in") {
+        for (size_t i = 0; i < NUM_REGS; i++) {
+            string name = mkstr("reg%zu", i);
+            regs.emplace_back(new reg<u32>(name, i * 4, (u32)i));
+            regs.back()->allow_read_write();
+        }
+    }
+
+    virtual ~regbank() = default;
+};
+
+class tlm_host_bench : public test_base
+{
+public:
+    regbank bank;
+    tlm_initiator_socket out;
+
+    tlm_host_bench(const sc_module_name& nm):
+        test_base(nm), bank("bank"), out("out") {
+        out.bind(bank.in);
+        clk_bind(*this, "clk", bank, "clk");
+        gpio_bind(*this, "rst", bank, "rst");
+    }
+
+    // only uses interfaces that predate process-indexed slots, so that the
+    // same benchmark can be run against older trees for comparison
+    void benchmark() {
+        const size_t lookups = 1000000;
+        const size_t transactions = 100000;
+
+        u64 t0 = mwr::timestamp_us();
+        for (size_t i = 0; i < lookups; i++)
+            bank.local_time() += SC_ZERO_TIME;
+        u64 t1 = mwr::timestamp_us();
+
+        size_t busy = 0;
+        for (size_t i = 0; i < lookups; i++)
+            busy += bank.in_transaction() ? 1 : 0;
+        u64 t2 = mwr::timestamp_us();
+        EXPECT_EQ(busy, 0);
+
+        u32 data = 0;
+        tlm_generic_payload tx;
+        for (size_t i = 0; i < transactions; i++) {
+            u64 addr = (i % regbank::NUM_REGS) * 4;
+            tx_setup(tx, TLM_READ_COMMAND, addr, &data, sizeof(data));
+            bank.transport(tx, SBI_NONE, VCML_AS_DEFAULT);
+            ASSERT_TRUE(tx.is_response_ok());
+            ASSERT_EQ(data, i % regbank::NUM_REGS);
+        }
+        u64 t3 = mwr::timestamp_us();
+
+        for (size_t i = 0; i < transactions; i++) {
+            u64 addr = (i % regbank::NUM_REGS) * 4;
+            ASSERT_OK(out.readw(addr, data, SBI_NODMI));
+            ASSERT_EQ(data, i % regbank::NUM_REGS);
+        }
+        u64 t4 = mwr::timestamp_us();
+
+        bank.local_time() = SC_ZERO_TIME;
+
+        std::cout << std::fixed << std::setprecision(1)
+                  << "tlm_host::local_time: " << (t1 - t0) * 1e3 / lookups
+                  << "ns" << std::endl
+                  << "tlm_host::in_transaction: "
+                  << (t2 - t1) * 1e3 / lookups << "ns" << std::endl
+                  << "peripheral::transport: "
+                  << (t3 - t2) * 1e3 / transactions << "ns" << std::endl
+                  << "register read via socket: "
+                  << (t4 - t3) * 1e3 / transactions << "ns" << std::endl;
+    }
+
+    virtual void run_test() override { benchmark(); }
+};
+
+TEST(tlm_host, benchmark) {
+    tlm_host_bench test("test");
+    sc_core::sc_start();
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class bench_port : public sc_object
+{
+public:
+    bench_port(const char* nm): sc_object(nm) {}
+};
+
+template <typename PAYLOAD>
+static double trace_rate(tracer_binary& tr, const sc_object& port,
+                         PAYLOAD& payload, size_t n) {
+    u64 start = mwr::timestamp_us();
+    for (size_t i = 0; i < n; i++) {
+        sc_time t(i, SC_NS);
+        const tracer::activity<PAYLOAD> msg = {
+            protocol<PAYLOAD>::KIND, TRACE_FW, false, port, payload, t, i,
+        };
+
+        tr.trace(msg);
+    }
+
+    u64 duration = max<u64>(mwr::timestamp_us() - start, 1);
+    return n * 1e6 / duration;
+}
+
+// the binary tracer should sustain at least 10M events/s per thread
+TEST(tracing, benchmark) {
+    const size_t n = 20000000;
+    bench_port port("port");
+
+    u32 data = 0;
+    tlm_generic_payload tx;
+    tx_setup(tx, TLM_READ_COMMAND, 0x1000, &data, sizeof(data));
+    tx.set_response_status(TLM_OK_RESPONSE);
+    gpio_payload gpio = { GPIO_NO_VECTOR, true };
+
+    tracer_binary binary("bench.bin");
+    double tlm_rate = trace_rate(binary, port, tx, n);
+    double gpio_rate = trace_rate(binary, port, gpio, n);
+    binary.flush();
+
+    EXPECT_EQ(binary.records(), 2 * n);
+    EXPECT_EQ(binary.dropped(), 0);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "tlm: " << tlm_rate / 1e6 << "M events/s" << std::endl
+              << "gpio: " << gpio_rate / 1e6 << "M events/s" << std::endl
+              << "file: " << binary.bytes_written() / MiB << "MiB"
+              << std::endl;
+
+    std::remove("bench.bin");
+}
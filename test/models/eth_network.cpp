@@ -0,0 +1,179 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class eth_node : public module, public eth_host
+{
+public:
+    mac_addr addr;
+    vector<eth_frame> received;
+
+    eth_initiator_socket eth_tx;
+    eth_target_socket eth_rx;
+
+    eth_node(const sc_module_name& nm, const mac_addr& mac):
+        module(nm),
+        eth_host(),
+        addr(mac),
+        received(),
+        eth_tx("eth_tx"),
+        eth_rx("eth_rx") {}
+
+    virtual void eth_receive(const eth_frame& frame) override {
+        received.push_back(frame);
+    }
+
+    void send(const mac_addr& dest) {
+        eth_tx.send(eth_frame(dest, addr, { 0x11, 0x22, 0x33, 0x44 }));
+    }
+
+    void send_vlan(const mac_addr& dest, u16 vlan, const mac_addr& src) {
+        vector<u8> raw = eth_frame(dest, src, { 0x11, 0x22, 0x33, 0x44 });
+        raw.insert(raw.begin() + 12, { 0x81, 0x00, (u8)(vlan >> 8), (u8)vlan });
+        eth_tx.send(eth_frame(raw));
+    }
+
+    size_t count() {
+        size_t n = received.size();
+        received.clear();
+        return n;
+    }
+};
+
+class network_bench : public test_base
+{
+public:
+    ethernet::network net;
+    eth_node a;
+    eth_node b;
+    eth_node c;
+
+    network_bench(const sc_module_name& nm):
+        test_base(nm),
+        net("net"),
+        a("a", "02:00:00:00:00:0a"),
+        b("b", "02:00:00:00:00:0b"),
+        c("c", "02:00:00:00:00:0c") {
+        net.connect(a);
+        net.connect(b);
+        net.connect(c);
+    }
+
+    virtual void run_test() override {
+        mac_addr bcast("ff:ff:ff:ff:ff:ff");
+        mac_addr unknown("02:00:00:00:00:ff");
+
+        // flooding mode delivers unicast frames to everyone
+        net.learning = false;
+        a.send(b.addr);
+        EXPECT_EQ(b.count(), 1);
+        EXPECT_EQ(c.count(), 1);
+        EXPECT_EQ(a.count(), 0);
+        EXPECT_EQ(net.fdb_size(), 0);
+
+        // learning mode floods until the destination is known
+        net.learning = true;
+        a.send(bcast);
+        EXPECT_EQ(b.count(), 1);
+        EXPECT_EQ(c.count(), 1);
+        EXPECT_EQ(net.fdb_size(), 1);
+
+        b.send(a.addr);
+        EXPECT_EQ(a.count(), 1);
+        EXPECT_EQ(c.count(), 0);
+        EXPECT_EQ(net.fdb_size(), 2);
+
+        a.send(b.addr);
+        EXPECT_EQ(b.count(), 1);
+        EXPECT_EQ(c.count(), 0);
+
+        c.send(unknown);
+        EXPECT_EQ(a.count(), 1);
+        EXPECT_EQ(b.count(), 1);
+        EXPECT_EQ(net.fdb_size(), 3);
+
+        ethernet::network::port_stats stats = net.get_stats(0);
+        EXPECT_EQ(stats.rx_frames, 3);
+        EXPECT_EQ(stats.tx_frames, 2);
+        EXPECT_EQ(stats.num_flooded, 2);
+
+        stringstream ss;
+        EXPECT_TRUE(net.execute("show_fdb", {}, ss));
+        EXPECT_NE(ss.str().find("02:00:00:00:00:0a port 0"), string::npos);
+        EXPECT_NE(ss.str().find("port 2: rx 1 frames"), string::npos);
+
+        // entries expire after the aging time
+        net.aging = sc_time(1, SC_MS);
+        wait(2, SC_MS);
+        b.send(a.addr);
+        EXPECT_EQ(a.count(), 1);
+        EXPECT_EQ(c.count(), 1);
+        EXPECT_EQ(net.fdb_size(), 2);
+
+        ss.str("");
+        EXPECT_TRUE(net.execute("show_fdb", {}, ss));
+        EXPECT_EQ(net.fdb_size(), 1);
+
+        test_vlan();
+    }
+
+    void test_vlan() {
+        mac_addr bcast("ff:ff:ff:ff:ff:ff");
+        mac_addr m("02:00:00:00:00:aa");
+
+        // the same address lives on port 0 in vlan 10 and port 1 in vlan 20
+        net.vlan_aware = true;
+        size_t n = net.fdb_size();
+        a.send_vlan(bcast, 10, m);
+        b.send_vlan(bcast, 20, m);
+        EXPECT_EQ(net.fdb_size(), n + 2);
+        a.count();
+        b.count();
+        c.count();
+
+        c.send_vlan(m, 10, c.addr);
+        EXPECT_EQ(a.count(), 1);
+        EXPECT_EQ(b.count(), 0);
+
+        c.send_vlan(m, 20, c.addr);
+        EXPECT_EQ(a.count(), 0);
+        EXPECT_EQ(b.count(), 1);
+
+        // untagged frames are in none of those vlans and get flooded
+        c.send(m);
+        EXPECT_EQ(a.count(), 1);
+        EXPECT_EQ(b.count(), 1);
+
+        stringstream ss;
+        EXPECT_TRUE(net.execute("show_fdb", {}, ss));
+        EXPECT_NE(ss.str().find("02:00:00:00:00:aa vlan 10 port 0"),
+                  string::npos);
+        EXPECT_NE(ss.str().find("02:00:00:00:00:aa vlan 20 port 1"),
+                  string::npos);
+
+        // without vlan awareness the second sender takes the address over
+        net.vlan_aware = false;
+        a.send_vlan(bcast, 10, m);
+        b.send_vlan(bcast, 20, m);
+        a.count();
+        b.count();
+        c.count();
+
+        c.send(m);
+        EXPECT_EQ(a.count(), 0);
+        EXPECT_EQ(b.count(), 1);
+    }
+};
+
+TEST(ethernet, network) {
+    network_bench bench("bench");
+    sc_core::sc_start();
+}
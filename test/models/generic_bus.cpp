@@ -161,6 +161,24 @@ public:
         EXPECT_OK(out2.readw<u32>(0xe800, data))
             << "cannot read from privately stubbed area";
 
+        EXPECT_AE(out1.readw<u32>(0xf000, data))
+            << "bus transaction went through for unmapped area";
+        bus.map(0, 0xf000, 0xf0ff);
+        EXPECT_OK(out1.readw<u32>(0xf000, data))
+            << "bus did not decode mapping added during simulation";
+        EXPECT_EQ(data, 0x11111111)
+            << "unexpected data from mapping added during simulation";
+
+        bus.map(1, 0x0000, 0x00ff, 0, 0);
+        EXPECT_OK(out1.readw<u32>(0x0000, data, SBI_NODMI))
+            << "cannot access memory at privately remapped area";
+        EXPECT_EQ(data, 0x55555555)
+            << "private mapping did not take precedence over shared one";
+        EXPECT_OK(out2.readw<u32>(0x0000, data, SBI_NODMI))
+            << "cannot access memory at shared area";
+        EXPECT_EQ(data, 0x11111111)
+            << "private mapping of out1 leaked to out2";
+
         bus.execute("mmap", std::cout);
         std::cout << std::endl;
     }
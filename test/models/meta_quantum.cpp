@@ -0,0 +1,61 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class quantum_harness : public test_base
+{
+public:
+    meta::adaptive_quantum quantum;
+
+    quantum_harness(const sc_module_name& nm):
+        test_base(nm), quantum("quantum") {
+        tlm::tlm_global_quantum::instance().set(sc_time(10, SC_NS));
+    }
+
+    virtual void run_test() override {
+        // quantum must have been raised to min_quantum
+        EXPECT_EQ(quantum.current_quantum(), quantum.min_quantum.get());
+
+        // no interactions: quantum should grow
+        wait(20, SC_MS);
+        sc_time grown = quantum.current_quantum();
+        EXPECT_GT(grown, quantum.min_quantum.get());
+        EXPECT_LE(grown, quantum.max_quantum.get());
+        EXPECT_GT(quantum.num_grow(), 0);
+        EXPECT_EQ(quantum.num_shrink(), 0);
+
+        // many interactions: quantum should shrink
+        for (int i = 0; i < 5; i++) {
+            for (u64 n = 0; n < quantum.shrink_threshold; n++)
+                notify_interaction();
+            wait(quantum.update_interval);
+        }
+
+        EXPECT_LT(quantum.current_quantum(), grown);
+        EXPECT_GT(quantum.num_shrink(), 0);
+
+        sc_time total;
+        for (const auto& [q, duration] : quantum.histogram()) {
+            EXPECT_GE(q, quantum.min_quantum.get());
+            EXPECT_LE(q, quantum.max_quantum.get());
+            total += duration;
+        }
+
+        EXPECT_EQ(total, sc_time_stamp());
+        EXPECT_TRUE(quantum.execute("show_stats", std::cout));
+        std::cout << std::endl;
+    }
+};
+
+TEST(meta, quantum) {
+    quantum_harness test("harness");
+    sc_core::sc_start();
+}
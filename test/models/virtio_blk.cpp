@@ -80,6 +80,7 @@ public:
         ASSERT_OK(out.writew(BLK_DEVF_SEL, 0u));
         ASSERT_OK(out.readw(BLK_DEVF, data));
         ASSERT_TRUE(data & (bit(5) | bit(6))); // readonly + block size
+        ASSERT_FALSE(data & bit(12));          // no multiqueue
         ASSERT_OK(out.writew(BLK_DRVF_SEL, 0u));
         ASSERT_OK(out.writew(BLK_DRVF, data));
 
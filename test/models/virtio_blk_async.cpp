@@ -0,0 +1,175 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+enum : u32 {
+    BLK_T_IN = 0,
+    BLK_T_GET_ID = 8,
+};
+
+enum : u8 {
+    BLK_S_OK = 0,
+    BLK_S_NONE = 0xff,
+};
+
+struct blk_header {
+    u32 type;
+    u32 reserved;
+    u64 sector;
+};
+
+struct blk_request {
+    blk_header header;
+    vector<u8> data;
+    u8 status;
+};
+
+// Acts as the virtio transport and hands out requests whose buffers live in
+// host memory, so that guest addresses equal host addresses.
+class virtio_blk_async_test : public test_base, public virtio_controller
+{
+public:
+    virtio_initiator_socket virtio_out;
+    virtio::blk blk;
+
+    deque<vq_message> pending;
+    vector<u32> completed;
+
+    virtio_blk_async_test(const sc_module_name& nm):
+        test_base(nm),
+        virtio_controller(),
+        virtio_out("virtio_out"),
+        blk("blk"),
+        pending(),
+        completed() {
+        virtio_out.bind(blk.virtio_in);
+    }
+
+    virtual bool put(u32 vqid, vq_message& msg) override {
+        EXPECT_EQ(vqid, 0);
+        completed.push_back(msg.index);
+        return true;
+    }
+
+    virtual bool get(u32 vqid, vq_message& msg) override {
+        if (pending.empty())
+            return false;
+
+        msg = pending.front();
+        pending.pop_front();
+        return true;
+    }
+
+    virtual bool notify() override { return true; }
+
+    void post(u32 index, blk_request& req, u32 type, u64 sector, size_t n) {
+        req.header = { type, 0, sector };
+        req.data.assign(n, 0xaa);
+        req.status = BLK_S_NONE;
+
+        vq_message msg;
+        msg.dmi = [](u64 addr, u64 size, vcml_access acs) -> u8* {
+            return (u8*)addr;
+        };
+
+        msg.index = index;
+        msg.append((uintptr_t)&req.header, sizeof(req.header), false);
+        msg.append((uintptr_t)req.data.data(), req.data.size(), true);
+        msg.append((uintptr_t)&req.status, sizeof(req.status), true);
+        pending.push_back(msg);
+    }
+
+    void wait_idle() {
+        while (blk.disk.in_flight() > 0)
+            wait(1, SC_US);
+    }
+
+    void test_out_of_order() {
+        // the read goes to a disk worker while get_id completes at once
+        blk_request rd, id;
+        post(0, rd, BLK_T_IN, 0, 64 * KiB);
+        post(1, id, BLK_T_GET_ID, 0, 20);
+        EXPECT_TRUE(virtio_out->notify(0));
+        EXPECT_EQ(completed, vector<u32>({ 1 }));
+        EXPECT_EQ(blk.disk.in_flight(), 1);
+
+        wait_idle();
+        EXPECT_EQ(completed, vector<u32>({ 1, 0 }));
+        EXPECT_EQ(rd.status, BLK_S_OK);
+        EXPECT_EQ(id.status, BLK_S_OK);
+        EXPECT_EQ(rd.data, vector<u8>(64 * KiB, 0));
+
+        // with in-order completion, get_id waits for the read before it
+        completed.clear();
+        EXPECT_TRUE(virtio_out->write_features(VIRTIO_F_IN_ORDER));
+        post(2, rd, BLK_T_IN, 0, 64 * KiB);
+        post(3, id, BLK_T_GET_ID, 0, 20);
+        EXPECT_TRUE(virtio_out->notify(0));
+        EXPECT_TRUE(completed.empty());
+        EXPECT_EQ(id.status, BLK_S_OK);
+
+        wait_idle();
+        EXPECT_EQ(completed, vector<u32>({ 2, 3 }));
+        EXPECT_EQ(rd.status, BLK_S_OK);
+    }
+
+    void test_reset() {
+        const u32 count = 16;
+        vector<blk_request> reqs(count);
+        for (u32 i = 0; i < count; i++)
+            post(i, reqs[i], BLK_T_IN, i * 2048, 1 * MiB);
+
+        completed.clear();
+        EXPECT_TRUE(virtio_out->write_features(0));
+        EXPECT_TRUE(virtio_out->notify(0));
+        EXPECT_EQ(blk.disk.in_flight(), count);
+
+        // once reset returns, the device must no longer touch the buffers
+        blk.reset();
+        EXPECT_EQ(blk.disk.in_flight(), 0);
+
+        vector<vector<u8>> snapshot;
+        for (const blk_request& req : reqs)
+            snapshot.push_back(req.data);
+
+        wait(1, SC_MS);
+        mwr::usleep(10000);
+        wait(1, SC_MS);
+
+        EXPECT_TRUE(completed.empty());
+        for (u32 i = 0; i < count; i++) {
+            EXPECT_EQ(reqs[i].status, BLK_S_NONE) << "request " << i;
+            EXPECT_EQ(reqs[i].data, snapshot[i]) << "request " << i;
+        }
+
+        // requests after the reset work as before
+        blk_request rd;
+        post(count, rd, BLK_T_IN, 0, 4 * KiB);
+        EXPECT_TRUE(virtio_out->notify(0));
+        wait_idle();
+        EXPECT_EQ(completed, vector<u32>({ count }));
+        EXPECT_EQ(rd.status, BLK_S_OK);
+    }
+
+    virtual void run_test() override {
+        ASSERT_EQ(blk.disk.io_threads, 2);
+        test_out_of_order();
+        test_reset();
+    }
+};
+
+TEST(virtio, blk_async) {
+    vcml::broker broker("test");
+    broker.define("test.blk.disk.io_threads", "2");
+
+    virtio_blk_async_test test("test");
+    sc_core::sc_start();
+}
@@ -0,0 +1,157 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+enum : u32 {
+    BLK_T_IN = 0,
+    BLK_T_GET_ID = 8,
+};
+
+enum : u8 {
+    BLK_S_OK = 0,
+    BLK_S_NONE = 0xff,
+};
+
+enum : u64 {
+    BLK_F_MQ = bit(12),
+};
+
+struct blk_header {
+    u32 type;
+    u32 reserved;
+    u64 sector;
+};
+
+struct blk_request {
+    blk_header header;
+    vector<u8> data;
+    u8 status;
+};
+
+// Acts as the virtio transport for a block device with two request queues,
+// keeping a separate list of pending requests for each of them.
+class virtio_blk_mq_test : public test_base, public virtio_controller
+{
+public:
+    virtio_initiator_socket virtio_out;
+    virtio::blk blk;
+
+    deque<vq_message> pending[2];
+    vector<std::pair<u32, u32>> completed;
+
+    virtio_blk_mq_test(const sc_module_name& nm):
+        test_base(nm),
+        virtio_controller(),
+        virtio_out("virtio_out"),
+        blk("blk"),
+        pending(),
+        completed() {
+        virtio_out.bind(blk.virtio_in);
+    }
+
+    virtual bool put(u32 vqid, vq_message& msg) override {
+        completed.push_back({ vqid, msg.index });
+        return true;
+    }
+
+    virtual bool get(u32 vqid, vq_message& msg) override {
+        EXPECT_LT(vqid, 2);
+        if (vqid >= 2 || pending[vqid].empty())
+            return false;
+
+        msg = pending[vqid].front();
+        pending[vqid].pop_front();
+        return true;
+    }
+
+    virtual bool notify() override { return true; }
+
+    void post(u32 vqid, u32 index, blk_request& req, u32 type, size_t n) {
+        req.header = { type, 0, 0 };
+        req.data.assign(n, 0xaa);
+        req.status = BLK_S_NONE;
+
+        vq_message msg;
+        msg.dmi = [](u64 addr, u64 size, vcml_access acs) -> u8* {
+            return (u8*)addr;
+        };
+
+        msg.index = index;
+        msg.append((uintptr_t)&req.header, sizeof(req.header), false);
+        msg.append((uintptr_t)req.data.data(), req.data.size(), true);
+        msg.append((uintptr_t)&req.status, sizeof(req.status), true);
+        pending[vqid].push_back(msg);
+    }
+
+    void wait_idle() {
+        while (blk.disk.in_flight() > 0)
+            wait(1, SC_US);
+    }
+
+    void test_config() {
+        virtio_device_desc desc;
+        desc.reset();
+        virtio_out->identify(desc);
+        EXPECT_EQ(desc.virtqueues.size(), 2);
+        EXPECT_EQ(desc.virtqueues.count(0), 1);
+        EXPECT_EQ(desc.virtqueues.count(1), 1);
+
+        u64 features = 0;
+        virtio_out->read_features(features);
+        EXPECT_TRUE(features & BLK_F_MQ);
+
+        // num_queues lives at offset 34 of the virtio-blk config space
+        u16 num_queues = 0;
+        EXPECT_TRUE(virtio_out->read_config({ 34, 35 }, &num_queues));
+        EXPECT_EQ(num_queues, 2);
+    }
+
+    void test_queues() {
+        // requests posted to queue 1 must complete on queue 1
+        blk_request rd, id;
+        post(1, 7, rd, BLK_T_IN, 4 * KiB);
+        post(1, 8, id, BLK_T_GET_ID, 20);
+        EXPECT_TRUE(virtio_out->notify(1));
+        wait_idle();
+
+        using completion = std::pair<u32, u32>;
+        EXPECT_EQ(completed, vector<completion>({ { 1, 7 }, { 1, 8 } }));
+        EXPECT_EQ(rd.status, BLK_S_OK);
+        EXPECT_EQ(id.status, BLK_S_OK);
+        EXPECT_EQ(rd.data, vector<u8>(4 * KiB, 0));
+
+        // queue 0 keeps working next to it
+        completed.clear();
+        blk_request rd0;
+        post(0, 9, rd0, BLK_T_IN, 4 * KiB);
+        EXPECT_TRUE(virtio_out->notify(0));
+        wait_idle();
+        EXPECT_EQ(completed, vector<completion>({ { 0, 9 } }));
+        EXPECT_EQ(rd0.status, BLK_S_OK);
+
+        // there is no third queue
+        EXPECT_FALSE(virtio_out->notify(2));
+    }
+
+    virtual void run_test() override {
+        ASSERT_EQ(blk.num_queues, 2);
+        test_config();
+        test_queues();
+    }
+};
+
+TEST(virtio, blk_mq) {
+    vcml::broker broker("test");
+    broker.define("test.blk.num_queues", "2");
+
+    virtio_blk_mq_test test("test");
+    sc_core::sc_start();
+}
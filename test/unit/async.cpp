@@ -28,6 +28,10 @@ public:
             mwr::usleep(1000);
             t += step;
             sc_progress(step);
+
+            // stay within three steps of SystemC
+            sc_async_wait(3 * step);
+            EXPECT_LT(async_time_offset(), 3 * step);
         }
 
         sc_sync([&]() -> void {
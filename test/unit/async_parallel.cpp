@@ -0,0 +1,79 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+#include "vcml/core/systemc.h"
+
+class async_parallel_test : public test_base
+{
+public:
+    const sc_time quantum;
+    const size_t num_quanta;
+
+    atomic<size_t> active;
+    atomic<bool> overlap;
+    size_t done;
+
+    sc_event finished;
+
+    async_parallel_test(const sc_module_name& nm):
+        test_base(nm),
+        quantum(1, SC_MS),
+        num_quanta(10),
+        active(0),
+        overlap(false),
+        done(0),
+        finished("finished") {
+        SC_HAS_PROCESS(async_parallel_test);
+        SC_THREAD(run_other);
+    }
+
+    void work() {
+        for (size_t i = 0; i < num_quanta; i++) {
+            if (++active > 1)
+                overlap = true;
+            mwr::usleep(5000);
+            active--;
+
+            sc_progress(quantum);
+            sc_async_barrier();
+            EXPECT_EQ(async_time_offset(), SC_ZERO_TIME);
+        }
+
+        sc_sync([&]() -> void {
+            EXPECT_TRUE(thctl_is_sysc_thread());
+            EXPECT_EQ(sc_time_stamp(), num_quanta * quantum);
+        });
+    }
+
+    void run_other() {
+        sc_async([&]() -> void { work(); }, true);
+        done++;
+        finished.notify(SC_ZERO_TIME);
+    }
+
+    virtual void run_test() override {
+        sc_async([&]() -> void { work(); }, true);
+        done++;
+
+        while (done < 2)
+            wait(finished);
+
+        sc_join_async();
+
+        EXPECT_TRUE(overlap);
+        EXPECT_EQ(sc_time_stamp(), num_quanta * quantum);
+    }
+};
+
+TEST(async, parallel) {
+    async_parallel_test test("async_parallel");
+    sc_core::sc_start();
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+#include "vcml/core/systemc.h"
+
+class async_sync_test : public test_base
+{
+public:
+    size_t num_jobs;
+
+    atomic<bool> posting;
+    atomic<bool> pending_ran;
+    atomic<bool> unwound;
+
+    sc_event start_pending;
+
+    async_sync_test(const sc_module_name& nm):
+        test_base(nm),
+        num_jobs(0),
+        posting(false),
+        pending_ran(false),
+        unwound(false),
+        start_pending("start_pending") {
+        SC_HAS_PROCESS(async_sync_test);
+        SC_THREAD(run_pending);
+    }
+
+    // sleeps long enough on both sides for the waiting thread to run out of
+    // spins and park on its doorbell, so that only a ring can wake it
+    void sync_jobs() {
+        EXPECT_TRUE(sc_is_async());
+        for (size_t i = 0; i < 3; i++) {
+            mwr::usleep(20000);
+            sc_sync([&]() -> void {
+                EXPECT_TRUE(thctl_is_sysc_thread());
+                mwr::usleep(20000);
+                num_jobs++;
+            });
+
+            EXPECT_EQ(num_jobs, i + 1);
+            sc_progress(sc_time(1, SC_MS));
+        }
+    }
+
+    void post_pending() {
+        struct unwind_guard {
+            atomic<bool>& flag;
+            ~unwind_guard() { flag = true; }
+        } guard{ unwound };
+
+        // SystemC has to wait for a whole second before it can run the
+        // job, but the simulation ends long before that
+        sc_progress(sc_time(1, SC_SEC));
+        posting = true;
+        sc_sync([&]() -> void { pending_ran = true; });
+        ADD_FAILURE() << "sc_sync returned after simulation ended";
+    }
+
+    void run_pending() {
+        wait(start_pending);
+        sc_async([&]() -> void { post_pending(); });
+    }
+
+    virtual void run_test() override {
+        sc_async([&]() -> void { sync_jobs(); }, true);
+        EXPECT_EQ(num_jobs, 3);
+        EXPECT_EQ(sc_time_stamp(), sc_time(3, SC_MS));
+
+        start_pending.notify(SC_ZERO_TIME);
+        while (!posting)
+            wait(SC_ZERO_TIME);
+
+        mwr::usleep(10000);
+        EXPECT_FALSE(pending_ran);
+    }
+};
+
+TEST(async, sync) {
+    async_sync_test test("async_sync");
+    sc_core::sc_start();
+
+    // the pending job must be dropped and its worker released
+    sc_join_async();
+    EXPECT_FALSE(test.pending_ran);
+    EXPECT_TRUE(test.unwound);
+    EXPECT_LT(sc_time_stamp(), sc_time(1, SC_SEC));
+}
@@ -101,6 +101,13 @@ TEST(disk, file) {
 
     EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
 
+    EXPECT_TRUE(disk.seek(0x10));
+    EXPECT_TRUE(disk.pwritev(0x3000, { { a, sizeof(a) } }));
+    EXPECT_TRUE(disk.preadv(0x3000, { { b, sizeof(b) } }));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+    EXPECT_EQ(disk.pos(), 0x10);
+    EXPECT_FALSE(disk.preadv(8 * MiB - 1, { { b, sizeof(b) } }));
+
     EXPECT_FALSE(disk.seek(8 * MiB + 1));
     EXPECT_TRUE(disk.seek(8 * MiB - 1));
     EXPECT_FALSE(disk.write(a, sizeof(a)));
@@ -108,6 +115,70 @@ TEST(disk, file) {
     std::remove("my.disk");
 }
 
+static void test_posix_file(const string& prefix) {
+    create_file("posix.disk", 8 * MiB);
+
+    block::disk disk("disk", prefix + "posix.disk");
+    EXPECT_EQ(disk.capacity(), 8 * MiB);
+    EXPECT_EQ(disk.pos(), 0);
+
+    u8 a[] = { 0x12, 0x34, 0x56, 0x78 };
+    u8 b[] = { 0x00, 0x00, 0x00, 0x00 };
+
+    EXPECT_TRUE(disk.seek(0xffe));
+    EXPECT_TRUE(disk.write(a, sizeof(a)));
+    EXPECT_TRUE(disk.seek(0xffe));
+    EXPECT_TRUE(disk.read(b, sizeof(b)));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+    EXPECT_EQ(disk.pos(), 0x1002);
+
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.wzero(8 * KiB));
+    EXPECT_TRUE(disk.seek(0xffe));
+    EXPECT_TRUE(disk.read(b, sizeof(b)));
+    EXPECT_EQ(b[0] | b[1] | b[2] | b[3], 0);
+
+    u8 c[] = { 0xaa, 0xbb, 0xcc };
+    u8 d[5] = {};
+    vector<block::iobuf> iov = { { a, sizeof(a) }, { c, sizeof(c) } };
+    EXPECT_TRUE(disk.seek(0x2000));
+    EXPECT_TRUE(disk.writev(iov));
+    EXPECT_EQ(disk.pos(), 0x2007);
+    iov = { { b, 2 }, { d, sizeof(d) } };
+    EXPECT_TRUE(disk.seek(0x2000));
+    EXPECT_TRUE(disk.readv(iov));
+    EXPECT_EQ(b[0], 0x12);
+    EXPECT_EQ(b[1], 0x34);
+    EXPECT_EQ(d[0], 0x56);
+    EXPECT_EQ(d[2], 0xaa);
+    EXPECT_EQ(d[4], 0xcc);
+
+    EXPECT_TRUE(disk.seek(0x10));
+    EXPECT_TRUE(disk.pwritev(0x3000, { { a, sizeof(a) } }));
+    EXPECT_TRUE(disk.preadv(0x3000, { { b, sizeof(b) } }));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+    EXPECT_EQ(disk.pos(), 0x10);
+    EXPECT_FALSE(disk.preadv(8 * MiB - 1, { { b, sizeof(b) } }));
+
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.discard(4 * KiB));
+    EXPECT_TRUE(disk.flush());
+
+    EXPECT_FALSE(disk.seek(8 * MiB + 1));
+    EXPECT_TRUE(disk.seek(8 * MiB - 1));
+    EXPECT_FALSE(disk.write(a, sizeof(a)));
+
+    std::remove("posix.disk");
+}
+
+TEST(disk, direct) {
+    test_posix_file("direct:");
+}
+
+TEST(disk, mmap) {
+    test_posix_file("mmap:");
+}
+
 TEST(disk, nothing) {
     mwr::publishers::terminal log;
     log.set_level(LOG_DEBUG);
@@ -179,3 +250,433 @@ TEST(ramdisk, unmap_zero) {
     EXPECT_EQ(disk.stats.num_req, 3);
     EXPECT_EQ(disk.stats.num_err, 0);
 }
+
+TEST(ramdisk, chunks) {
+    mwr::publishers::terminal log;
+    log.set_level(LOG_DEBUG);
+
+    block::disk disk("disk", "ramdisk:16GiB", false);
+    EXPECT_EQ(disk.capacity(), 16 * GiB);
+
+    const size_t chunk = 64 * KiB;
+    vector<u8> a(3 * chunk);
+    vector<u8> b(a.size());
+    for (size_t i = 0; i < a.size(); i++)
+        a[i] = (u8)(i * 7 + 1);
+
+    u64 addr = 15 * GiB - 3;
+    EXPECT_TRUE(disk.seek(addr));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(disk.seek(addr));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(a, b);
+
+    EXPECT_TRUE(disk.seek(15 * GiB));
+    EXPECT_TRUE(disk.wzero(2 * chunk));
+    EXPECT_TRUE(disk.seek(addr));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    for (size_t i = 0; i < b.size(); i++) {
+        bool zero = i >= 3 && i < 3 + 2 * chunk;
+        ASSERT_EQ(b[i], zero ? 0 : a[i]) << "at offset " << i;
+    }
+}
+
+TEST(disk, cow) {
+    mwr::publishers::terminal log;
+    log.set_level(LOG_DEBUG);
+
+    create_file("base.disk", 1 * MiB);
+
+    u8 a[] = { 0x12, 0x34, 0x56, 0x78 };
+    u8 b[] = { 0x00, 0x00, 0x00, 0x00 };
+
+    {
+        block::disk disk("disk", "cow:base.disk,overlay.disk");
+        EXPECT_EQ(disk.capacity(), 1 * MiB);
+        EXPECT_TRUE(disk.seek(0xffe));
+        EXPECT_TRUE(disk.write(a, sizeof(a)));
+
+        stringstream ss;
+        EXPECT_TRUE(disk.execute("save_image", { "flat.disk" }, ss));
+    }
+
+    block::disk base("base", "base.disk", true);
+    EXPECT_TRUE(base.seek(0xffe));
+    EXPECT_TRUE(base.read(b, sizeof(b)));
+    EXPECT_EQ(b[0] | b[1] | b[2] | b[3], 0);
+
+    block::disk flat("flat", "flat.disk", true);
+    EXPECT_EQ(flat.capacity(), 1 * MiB);
+    EXPECT_TRUE(flat.seek(0xffe));
+    EXPECT_TRUE(flat.read(b, sizeof(b)));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+
+    {
+        block::disk again("again", "cow:base.disk,overlay.disk");
+        EXPECT_TRUE(again.seek(0xffe));
+        EXPECT_TRUE(again.read(b, sizeof(b)));
+        EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+    }
+
+    std::remove("base.disk");
+    std::remove("flat.disk");
+    std::remove("overlay.disk");
+    std::remove("overlay.disk.map");
+}
+
+TEST(disk, cow_map) {
+    create_file("base.disk", 1 * MiB);
+
+    u8 a[] = { 0x12, 0x34, 0x56, 0x78 };
+    u8 b[] = { 0x00, 0x00, 0x00, 0x00 };
+
+    {
+        // the map must exist before the first flush, so that a run that
+        // gets killed early leaves a usable overlay behind
+        block::disk disk("disk", "cow:base.disk,fresh.disk");
+        EXPECT_TRUE(mwr::file_exists("fresh.disk.map"));
+
+        block::disk killed("killed", "cow:base.disk,fresh.disk", true);
+        EXPECT_EQ(killed.capacity(), 1 * MiB);
+
+        EXPECT_TRUE(disk.seek(0x1000));
+        EXPECT_TRUE(disk.write(a, sizeof(a)));
+        EXPECT_TRUE(disk.flush());
+        EXPECT_FALSE(mwr::file_exists("fresh.disk.map.tmp"));
+    }
+
+    block::disk again("again", "cow:base.disk,fresh.disk", true);
+    EXPECT_TRUE(again.seek(0x1000));
+    EXPECT_TRUE(again.read(b, sizeof(b)));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+
+    std::remove("base.disk");
+    std::remove("fresh.disk");
+    std::remove("fresh.disk.map");
+}
+
+TEST(disk, cache) {
+    vcml::broker broker("test");
+    broker.define("cached.cache_size", "65536");
+    broker.define("cached.cache_policy", "unsafe");
+
+    create_file("cache.disk", 1 * MiB);
+
+    u8 a[] = { 0x12, 0x34, 0x56, 0x78 };
+    u8 b[] = { 0x00, 0x00, 0x00, 0x00 };
+
+    {
+        block::disk disk("cached", "cache.disk");
+        ASSERT_TRUE(disk.has_cache());
+        EXPECT_EQ(disk.get_flush_policy(), block::disk::FLUSH_UNSAFE);
+
+        EXPECT_TRUE(disk.seek(0x1ffe));
+        EXPECT_TRUE(disk.write(a, sizeof(a)));
+        EXPECT_TRUE(disk.flush());
+
+        block::disk image("image", "cache.disk", true);
+        EXPECT_FALSE(image.has_cache());
+        EXPECT_TRUE(image.seek(0x1ffe));
+        EXPECT_TRUE(image.read(b, sizeof(b)));
+        EXPECT_EQ(b[0] | b[1] | b[2] | b[3], 0);
+
+        EXPECT_TRUE(disk.seek(0x1ffe));
+        EXPECT_TRUE(disk.read(b, sizeof(b)));
+        EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+
+        stringstream ss;
+        EXPECT_TRUE(disk.execute("show_stats", ss));
+        EXPECT_NE(ss.str().find("cache hits"), string::npos);
+    }
+
+    block::disk image("image", "cache.disk", true);
+    EXPECT_TRUE(image.seek(0x1ffe));
+    EXPECT_TRUE(image.read(b, sizeof(b)));
+    EXPECT_EQ(memcmp(a, b, sizeof(a)), 0);
+
+    std::remove("cache.disk");
+}
+
+static u64 cache_stat(block::disk& disk, const string& name) {
+    stringstream ss;
+    EXPECT_TRUE(disk.execute("show_stats", ss));
+
+    string line;
+    while (std::getline(ss, line)) {
+        if (starts_with(line, "cache " + name))
+            return std::stoull(line.substr(line.find_last_of(' ') + 1));
+    }
+
+    ADD_FAILURE() << "show_stats does not report cache " << name;
+    return 0;
+}
+
+static bool check_image(const string& path, size_t off, const vector<u8>& v) {
+    block::disk image("image", path, true);
+    vector<u8> data(v.size());
+    EXPECT_TRUE(image.seek(off));
+    EXPECT_TRUE(image.read(data.data(), data.size()));
+    return data == v;
+}
+
+TEST(disk, cache_evict) {
+    vcml::broker broker("test");
+    broker.define("cached.cache_size", "16384");
+    broker.define("cached.cache_policy", "unsafe");
+
+    create_file("evict.disk", 1 * MiB);
+
+    const size_t page = 4 * KiB;
+    vector<u8> a(3 * page, 0xaa);
+    vector<u8> b(page);
+
+    block::disk disk("cached", "direct:evict.disk");
+    ASSERT_TRUE(disk.has_cache());
+
+    // dirty pages 0..2, nothing may reach the image before eviction
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(disk.flush());
+    EXPECT_TRUE(check_image("evict.disk", 0, vector<u8>(a.size(), 0)));
+    EXPECT_EQ(cache_stat(disk, "writebacks"), 0);
+
+    // fill the last slot and make page 0 the most recently used page
+    EXPECT_TRUE(disk.seek(10 * page));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(cache_stat(disk, "hits"), 1);
+    EXPECT_EQ(cache_stat(disk, "misses"), 4);
+
+    // evicting page 1 writes all three dirty pages back in one go
+    EXPECT_TRUE(disk.seek(11 * page));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(cache_stat(disk, "writebacks"), 1);
+    EXPECT_TRUE(check_image("evict.disk", 0, a));
+
+    // page 0 was used last and must still be cached
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(cache_stat(disk, "hits"), 2);
+    EXPECT_EQ(b, vector<u8>(page, 0xaa));
+
+    // evicting the pages that were written back costs no further writes
+    EXPECT_TRUE(disk.seek(12 * page));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_TRUE(disk.seek(13 * page));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(cache_stat(disk, "writebacks"), 1);
+
+    EXPECT_TRUE(disk.seek(page));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(b, vector<u8>(page, 0xaa));
+
+    std::remove("evict.disk");
+}
+
+TEST(disk, cache_writethrough) {
+    vcml::broker broker("test");
+    broker.define("cached.cache_size", "16384");
+    broker.define("cached.cache_policy", "writethrough");
+
+    create_file("wt.disk", 1 * MiB);
+
+    vector<u8> a = { 0x12, 0x34, 0x56, 0x78 };
+    vector<u8> b(a.size());
+
+    block::disk disk("cached", "direct:wt.disk");
+    ASSERT_TRUE(disk.has_cache());
+    EXPECT_EQ(disk.get_flush_policy(), block::disk::FLUSH_WRITETHROUGH);
+
+    // a write to a cached page goes to the image and refreshes the page
+    EXPECT_TRUE(disk.seek(0x10));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(cache_stat(disk, "misses"), 1);
+    EXPECT_TRUE(disk.seek(0x10));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(check_image("wt.disk", 0x10, a));
+    EXPECT_TRUE(disk.seek(0x10));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(b, a);
+    EXPECT_EQ(cache_stat(disk, "hits"), 1);
+
+    // a write to an uncached page must not pull it into the cache
+    EXPECT_TRUE(disk.seek(0x5ffe));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(check_image("wt.disk", 0x5ffe, a));
+    EXPECT_EQ(cache_stat(disk, "misses"), 1);
+
+    EXPECT_TRUE(disk.flush());
+    EXPECT_EQ(cache_stat(disk, "writebacks"), 0);
+
+    std::remove("wt.disk");
+}
+
+TEST(disk, cache_invalidate) {
+    vcml::broker broker("test");
+    broker.define("cached.cache_size", "65536");
+    broker.define("cached.cache_policy", "unsafe");
+
+    create_file("inval.disk", 1 * MiB);
+
+    const size_t page = 4 * KiB;
+    const size_t half = page / 2;
+    vector<u8> a(2 * page, 0xaa);
+    vector<u8> b(2 * page);
+
+    block::disk disk("cached", "direct:inval.disk");
+    ASSERT_TRUE(disk.has_cache());
+
+    // zero the middle of two dirty pages, their outer halves must survive
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(disk.seek(half));
+    EXPECT_TRUE(disk.wzero(page));
+
+    vector<u8> expect(a);
+    std::fill(expect.begin() + half, expect.begin() + half + page, 0);
+    EXPECT_TRUE(check_image("inval.disk", 0, expect));
+    EXPECT_TRUE(disk.seek(0));
+    EXPECT_TRUE(disk.read(b.data(), b.size()));
+    EXPECT_EQ(b, expect);
+
+    // the same for discard, without looking at the discarded data
+    EXPECT_TRUE(disk.seek(2 * page));
+    EXPECT_TRUE(disk.write(a.data(), a.size()));
+    EXPECT_TRUE(disk.seek(2 * page + half));
+    EXPECT_TRUE(disk.discard(page));
+
+    vector<u8> outer(half, 0xaa);
+    EXPECT_TRUE(check_image("inval.disk", 2 * page, outer));
+    EXPECT_TRUE(check_image("inval.disk", 3 * page + half, outer));
+
+    vector<u8> c(half);
+    EXPECT_TRUE(disk.seek(2 * page));
+    EXPECT_TRUE(disk.read(c.data(), c.size()));
+    EXPECT_EQ(c, outer);
+    EXPECT_TRUE(disk.seek(3 * page + half));
+    EXPECT_TRUE(disk.read(c.data(), c.size()));
+    EXPECT_EQ(c, outer);
+
+    std::remove("inval.disk");
+}
+
+TEST(disk, stats) {
+    block::disk disk("disk", "ramdisk:8MiB");
+
+    u8 buf[512] = {};
+    EXPECT_TRUE(disk.write(buf, sizeof(buf)));
+    EXPECT_TRUE(disk.write(buf, sizeof(buf)));
+    EXPECT_TRUE(disk.seek(4 * MiB));
+    EXPECT_TRUE(disk.read(buf, sizeof(buf)));
+    EXPECT_TRUE(disk.flush());
+
+    EXPECT_EQ(disk.stats.num_seq_req, 2);
+    EXPECT_EQ(disk.stats.num_rand_req, 1);
+    EXPECT_EQ(disk.stats.lat_write.count(), 2);
+    EXPECT_EQ(disk.stats.lat_read.count(), 1);
+    EXPECT_EQ(disk.stats.lat_flush.count(), 1);
+    EXPECT_EQ(disk.stats.lat_discard.count(), 0);
+    EXPECT_LE(disk.stats.lat_read.percentile_ns(50),
+              disk.stats.lat_read.max_ns());
+
+    stringstream ss;
+    EXPECT_TRUE(disk.execute("show_stats", ss));
+    EXPECT_NE(ss.str().find("write latency"), string::npos);
+
+    property_base* attr = dynamic_cast<property_base*>(
+        disk.get_attribute("stats"));
+    ASSERT_NE(attr, nullptr);
+    string json = attr->str();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"bytes_written\":1024"), string::npos);
+    EXPECT_NE(json.find("\"seq_req\":2"), string::npos);
+}
+
+TEST(disk, stats_interval) {
+    vcml::broker broker("stats");
+    broker.define("disk.stats_file", "zero.csv");
+    broker.define("disk.stats_interval", "0");
+
+    block::disk disk("disk", "ramdisk:8MiB");
+    EXPECT_EQ(disk.stats_interval.get(), SC_ZERO_TIME);
+    EXPECT_FALSE(ifstream("zero.csv").good());
+}
+
+class disk_async_test : public test_base
+{
+public:
+    block::disk disk;
+
+    disk_async_test(const sc_module_name& nm):
+        test_base(nm), disk("disk", "ramdisk:8MiB") {}
+
+    void wait_for(const size_t& done, size_t count) {
+        while (done < count)
+            wait(1, SC_US);
+    }
+
+    virtual void run_test() override {
+        ASSERT_EQ(disk.io_threads, 4);
+
+        const size_t count = 16;
+        vector<u8> a(4 * KiB), b(4 * KiB);
+        for (size_t i = 0; i < a.size(); i++)
+            a[i] = (u8)i;
+
+        size_t done = 0;
+        auto complete = [&](block::disk::request& req) -> void {
+            EXPECT_TRUE(thctl_is_sysc_thread());
+            EXPECT_TRUE(req.success);
+            done++;
+        };
+
+        vector<block::disk::request> reqs(count);
+        for (size_t i = 0; i < count; i++) {
+            reqs[i].type = block::disk::REQ_WRITE;
+            reqs[i].offset = i * a.size();
+            reqs[i].iov = { { a.data(), a.size() } };
+            reqs[i].complete = complete;
+            disk.submit(reqs[i]);
+        }
+
+        EXPECT_EQ(done, 0);
+        EXPECT_EQ(disk.in_flight(), count);
+        wait_for(done, count);
+        EXPECT_EQ(disk.in_flight(), 0);
+        EXPECT_EQ(disk.stats.num_bytes_written, count * a.size());
+
+        done = 0;
+        EXPECT_TRUE(disk.seek(0x123));
+        block::disk::request rd;
+        rd.type = block::disk::REQ_READ;
+        rd.offset = 5 * a.size();
+        rd.iov = { { b.data(), b.size() } };
+        rd.complete = complete;
+        disk.submit(rd);
+        wait_for(done, 1);
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(disk.pos(), 0x123);
+
+        done = 0;
+        block::disk::request bad;
+        bad.type = block::disk::REQ_READ;
+        bad.offset = 8 * MiB;
+        bad.iov = { { b.data(), b.size() } };
+        bad.complete = [&](block::disk::request& req) -> void {
+            EXPECT_FALSE(req.success);
+            done++;
+        };
+        disk.submit(bad);
+        wait_for(done, 1);
+    }
+};
+
+TEST(disk, async) {
+    vcml::broker broker("test");
+    broker.define("test.disk.io_threads", "4");
+
+    disk_async_test test("test");
+    sc_core::sc_start();
+}
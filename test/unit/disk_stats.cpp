@@ -0,0 +1,98 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+static vector<string> read_lines(const string& path) {
+    ifstream is(path);
+    vector<string> lines;
+    string line;
+    while (std::getline(is, line))
+        lines.push_back(line);
+    return lines;
+}
+
+static size_t column(const string& header, const string& name) {
+    vector<string> names = split(header, ',');
+    return std::find(names.begin(), names.end(), name) - names.begin();
+}
+
+class disk_stats_test : public test_base
+{
+public:
+    block::disk csv;
+    block::disk json;
+
+    disk_stats_test(const sc_module_name& nm):
+        test_base(nm),
+        csv("csv", "ramdisk:8MiB"),
+        json("json", "ramdisk:8MiB") {}
+
+    void test_csv() {
+        vector<string> lines = read_lines("disk_stats.csv");
+        ASSERT_GE(lines.size(), 3);
+
+        // one header row followed by one row per sample
+        const string& header = lines.front();
+        EXPECT_TRUE(starts_with(header, "sim_time,host_time,bytes_read,"));
+        size_t col = column(header, "bytes_written");
+        ASSERT_LT(col, split(header, ',').size());
+
+        for (size_t i = 1; i < lines.size(); i++) {
+            vector<string> row = split(lines[i], ',');
+            ASSERT_EQ(row.size(), split(header, ',').size()) << lines[i];
+            EXPECT_FALSE(starts_with(lines[i], "sim_time"));
+        }
+
+        EXPECT_EQ(split(lines.back(), ',')[col], "1024");
+    }
+
+    void test_json() {
+        vector<string> lines = read_lines("disk_stats.json");
+        ASSERT_GE(lines.size(), 2);
+
+        // one complete object per sample and no header
+        for (const string& line : lines) {
+            ASSERT_FALSE(line.empty());
+            EXPECT_EQ(line.front(), '{') << line;
+            EXPECT_EQ(line.back(), '}') << line;
+            EXPECT_NE(line.find("\"sim_time\":"), string::npos) << line;
+        }
+
+        EXPECT_NE(lines.back().find("\"bytes_written\":1024"), string::npos);
+    }
+
+    virtual void run_test() override {
+        u8 buf[512] = {};
+        EXPECT_TRUE(csv.write(buf, sizeof(buf)));
+        EXPECT_TRUE(csv.write(buf, sizeof(buf)));
+        EXPECT_TRUE(json.write(buf, sizeof(buf)));
+        EXPECT_TRUE(json.write(buf, sizeof(buf)));
+
+        // samples get taken at 0ms, 1ms, 2ms and 3ms
+        wait(3500, SC_US);
+        test_csv();
+        test_json();
+
+        std::remove("disk_stats.csv");
+        std::remove("disk_stats.json");
+    }
+};
+
+TEST(disk, stats_file) {
+    vcml::broker broker("test");
+    broker.define("test.csv.stats_file", "disk_stats.csv");
+    broker.define("test.csv.stats_interval", "1ms");
+    broker.define("test.json.stats_file", "disk_stats.json");
+    broker.define("test.json.stats_interval", "1ms");
+
+    disk_stats_test test("test");
+    sc_core::sc_start();
+}
@@ -108,3 +108,70 @@ TEST(dmi, lookup) {
     EXPECT_EQ(vcml::dmi_get_ptr(dmi2, 997), dummy + 997);
     EXPECT_FALSE(cache.lookup(998, 4, tlm::TLM_READ_COMMAND, dmi2));
 }
+
+TEST(dmi, lookup_overlapping) {
+    unsigned char dummy[4096];
+    vcml::tlm_dmi_cache cache;
+    tlm::tlm_dmi dmi, dmi2;
+
+    dmi.allow_read();
+    dmi.set_start_address(0);
+    dmi.set_end_address(3000);
+    dmi.set_dmi_ptr(dummy + dmi.get_start_address());
+    cache.insert(dmi);
+
+    dmi.allow_read_write();
+    dmi.set_start_address(1000);
+    dmi.set_end_address(1999);
+    dmi.set_dmi_ptr(dummy + dmi.get_start_address());
+    cache.insert(dmi);
+
+    dmi.allow_read_write();
+    dmi.set_start_address(2000);
+    dmi.set_end_address(2100);
+    dmi.set_dmi_ptr(dummy + 3000);
+    cache.insert(dmi);
+
+    EXPECT_EQ(cache.get_entries().size(), 3);
+    EXPECT_TRUE(cache.lookup(500, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_EQ(vcml::dmi_get_ptr(dmi2, 500), dummy + 500);
+    EXPECT_FALSE(cache.lookup(500, 4, tlm::TLM_WRITE_COMMAND, dmi2));
+    EXPECT_TRUE(cache.lookup(1500, 4, tlm::TLM_WRITE_COMMAND, dmi2));
+    EXPECT_EQ(vcml::dmi_get_ptr(dmi2, 1500), dummy + 1500);
+    EXPECT_TRUE(cache.lookup(2050, 4, tlm::TLM_WRITE_COMMAND, dmi2));
+    EXPECT_EQ(vcml::dmi_get_ptr(dmi2, 2050), dummy + 3050);
+    EXPECT_FALSE(cache.lookup(1998, 4, tlm::TLM_WRITE_COMMAND, dmi2));
+    EXPECT_TRUE(cache.lookup(2500, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_EQ(vcml::dmi_get_ptr(dmi2, 2500), dummy + 2500);
+}
+
+TEST(dmi, lookup_invalidated) {
+    unsigned char dummy[4096];
+    vcml::tlm_dmi_cache cache;
+    tlm::tlm_dmi dmi, dmi2;
+
+    dmi.allow_read_write();
+    dmi.set_start_address(0);
+    dmi.set_end_address(1000);
+    dmi.set_dmi_ptr(dummy + dmi.get_start_address());
+    cache.insert(dmi);
+
+    EXPECT_TRUE(cache.lookup(200, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_TRUE(cache.lookup(204, 4, tlm::TLM_READ_COMMAND, dmi2));
+    cache.invalidate(100, 299);
+    EXPECT_FALSE(cache.lookup(200, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_TRUE(cache.lookup(300, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_TRUE(cache.lookup(96, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_FALSE(cache.lookup(98, 4, tlm::TLM_READ_COMMAND, dmi2));
+
+    std::thread other([&]() {
+        tlm::tlm_dmi dmi3;
+        EXPECT_TRUE(cache.lookup(500, 4, tlm::TLM_READ_COMMAND, dmi3));
+        cache.invalidate(0, -1);
+        EXPECT_FALSE(cache.lookup(500, 4, tlm::TLM_READ_COMMAND, dmi3));
+    });
+
+    other.join();
+    EXPECT_FALSE(cache.lookup(300, 4, tlm::TLM_READ_COMMAND, dmi2));
+    EXPECT_TRUE(cache.get_entries().empty());
+}
@@ -48,6 +48,56 @@ TEST(ethernet, frame) {
     EXPECT_FALSE(failed(frame));
 }
 
+TEST(ethernet, frame_sharing) {
+    vector<u8> data = { 0x11, 0x22, 0x33, 0x44 };
+    eth_frame a("ff:ff:ff:ff:ff:ff", "12:23:34:45:56:67", data);
+    EXPECT_EQ(a.use_count(), 1);
+
+    eth_frame b(a);
+    EXPECT_TRUE(b.shares(a));
+    EXPECT_EQ(b.data(), a.data());
+    EXPECT_EQ(a.use_count(), 2);
+    EXPECT_EQ(b, a);
+
+    b.mutable_data()[eth_frame::FRAME_HEADER_SIZE] = 0xff;
+    EXPECT_FALSE(b.shares(a));
+    EXPECT_NE(b.data(), a.data());
+    EXPECT_EQ(a.use_count(), 1);
+    EXPECT_EQ(b.use_count(), 1);
+    EXPECT_EQ(a.payload(0), 0x11);
+    EXPECT_EQ(b.payload(0), 0xff);
+    EXPECT_NE(b, a);
+
+    eth_frame c(std::move(b));
+    EXPECT_TRUE(b.empty());
+    EXPECT_EQ(b.use_count(), 0);
+    EXPECT_EQ(c.payload(0), 0xff);
+
+    size_t pooled = eth_frame::pool_size();
+    const u8* ptr = c.data();
+    c = a;
+    EXPECT_TRUE(c.shares(a));
+    EXPECT_EQ(eth_frame::pool_size(), pooled + 1);
+
+    eth_frame d(data);
+    EXPECT_EQ(d.data(), ptr);
+    EXPECT_EQ(d.size(), eth_frame::FRAME_MIN_SIZE);
+    EXPECT_EQ(eth_frame::pool_size(), pooled);
+
+    // moving in a small vector must keep using the pooled storage
+    d = eth_frame();
+    vector<u8> small(data);
+    eth_frame e(std::move(small));
+    EXPECT_EQ(e.data(), ptr);
+    EXPECT_EQ(e.size(), eth_frame::FRAME_MIN_SIZE);
+
+    // a vector that is big enough for any frame gets taken over
+    vector<u8> big(eth_frame::FRAME_MAX_SIZE, 0x55);
+    const u8* storage = big.data();
+    eth_frame f(std::move(big));
+    EXPECT_EQ(f.data(), storage);
+}
+
 MATCHER_P(eth_match_socket, socket, "Matches an ethernet socket") {
     return &arg == socket;
 }
@@ -56,6 +106,10 @@ MATCHER_P(eth_match_frame, frame, "Matches an ethernet frame") {
     return arg == frame;
 }
 
+MATCHER_P(eth_share_frame, frame, "Matches a shared ethernet frame") {
+    return arg.shares(frame);
+}
+
 class ethernet_bench : public test_base, public eth_host
 {
 public:
@@ -108,7 +162,7 @@ public:
         vector<u8> data = { 0x11, 0x22, 0x33, 0x44 };
         eth_frame frame("ff:ff:ff:ff:ff:ff", "12:23:34:45:56:67", data);
 
-        EXPECT_CALL(*this, eth_receive(_, eth_match_frame(frame)));
+        EXPECT_CALL(*this, eth_receive(_, eth_share_frame(frame)));
         eth_tx.send(frame);
 
         EXPECT_CALL(*this, eth_link_down());
@@ -0,0 +1,168 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+static eth_frame make_frame(u16 seq) {
+    vector<u8> payload = { (u8)seq, (u8)(seq >> 8) };
+    return eth_frame("ff:ff:ff:ff:ff:ff", "12:23:34:45:56:67", payload);
+}
+
+static u16 frame_seq(const eth_frame& frame) {
+    size_t off = eth_frame::FRAME_HEADER_SIZE;
+    return frame[off] | (u16)frame[off + 1] << 8;
+}
+
+class test_backend : public ethernet::backend
+{
+public:
+    size_t num_observed;
+
+    test_backend(ethernet::bridge* br):
+        ethernet::backend(br), num_observed(0) {
+        m_type = "test";
+    }
+
+    virtual void send_to_host(const eth_frame& frame) override {
+        // nothing to do
+    }
+
+    virtual void observe_to_guest(const eth_frame& frame) override {
+        num_observed++;
+    }
+};
+
+class bridge_test : public test_base, public eth_host
+{
+public:
+    ethernet::bridge bridge;
+    test_backend backend;
+
+    eth_initiator_socket eth_tx;
+    eth_target_socket eth_rx;
+
+    vector<u16> received;
+    vector<u64> deltas;
+
+    bridge_test(const sc_module_name& nm):
+        test_base(nm),
+        eth_host(),
+        bridge("bridge"),
+        backend(&bridge),
+        eth_tx("eth_tx"),
+        eth_rx("eth_rx"),
+        received(),
+        deltas() {
+        eth_tx.bind(bridge.eth_rx);
+        bridge.eth_tx.bind(eth_rx);
+    }
+
+    virtual void eth_receive(const eth_target_socket& socket,
+                             const eth_frame& frame) override {
+        received.push_back(frame_seq(frame));
+        deltas.push_back(sc_core::sc_delta_count());
+    }
+
+    void clear() {
+        received.clear();
+        deltas.clear();
+        backend.num_observed = 0;
+    }
+
+    void test_interleaved() {
+        vector<eth_frame> batch = { make_frame(1), make_frame(2) };
+        backend.send_to_guest(make_frame(0));
+        backend.send_to_guest(batch);
+        EXPECT_TRUE(batch.empty());
+        backend.send_to_guest(make_frame(3));
+        batch = { make_frame(4) };
+        backend.send_to_guest(batch);
+        EXPECT_TRUE(received.empty());
+
+        // the update scheduled by the first frame covers all the others
+        wait(1, SC_NS);
+        EXPECT_EQ(received, vector<u16>({ 0, 1, 2, 3, 4 }));
+        EXPECT_EQ(backend.num_observed, 5);
+        EXPECT_EQ(deltas.front(), deltas.back());
+
+        // a batch into an idle queue schedules the update itself
+        clear();
+        batch = { make_frame(5), make_frame(6) };
+        backend.send_to_guest(batch);
+        backend.send_to_guest(make_frame(7));
+        vector<eth_frame> none;
+        backend.send_to_guest(none);
+        wait(1, SC_NS);
+        EXPECT_EQ(received, vector<u16>({ 5, 6, 7 }));
+        EXPECT_EQ(deltas.front(), deltas.back());
+
+        // an empty batch must not schedule anything
+        clear();
+        backend.send_to_guest(none);
+        wait(1, SC_NS);
+        EXPECT_TRUE(received.empty());
+
+        // untimed frames do not wait for timed frames queued before them
+        sc_time t = sc_time_stamp() + sc_time(10, SC_NS);
+        backend.send_to_guest_at(make_frame(9), t);
+        batch = { make_frame(8) };
+        backend.send_to_guest(batch);
+        wait(1, SC_NS);
+        EXPECT_EQ(received, vector<u16>({ 8 }));
+        wait(10, SC_NS);
+        EXPECT_EQ(received, vector<u16>({ 8, 9 }));
+        EXPECT_EQ(bridge.late_frames(), 0);
+
+        // timed frames from the past are delivered at once and counted
+        backend.send_to_guest_at(make_frame(10), SC_ZERO_TIME);
+        wait(1, SC_NS);
+        EXPECT_EQ(received, vector<u16>({ 8, 9, 10 }));
+        EXPECT_EQ(bridge.late_frames(), 1);
+    }
+
+    void test_threaded() {
+        const u16 count = 1000;
+        clear();
+
+        // singles and batches from a host thread must stay in order
+        std::thread producer([&]() -> void {
+            vector<eth_frame> batch;
+            for (u16 seq = 0; seq < count; seq++) {
+                if (seq % 3 == 0) {
+                    backend.send_to_guest(batch);
+                    backend.send_to_guest(make_frame(seq));
+                } else {
+                    batch.push_back(make_frame(seq));
+                }
+            }
+
+            backend.send_to_guest(batch);
+        });
+
+        for (size_t i = 0; i < 1000000 && received.size() < count; i++)
+            wait(1, SC_US);
+
+        producer.join();
+        ASSERT_EQ(received.size(), count);
+        for (u16 seq = 0; seq < count; seq++)
+            EXPECT_EQ(received[seq], seq);
+        EXPECT_EQ(backend.num_observed, count);
+    }
+
+    virtual void run_test() override {
+        test_interleaved();
+        test_threaded();
+    }
+};
+
+TEST(ethernet, bridge) {
+    bridge_test test("test");
+    sc_core::sc_start();
+}
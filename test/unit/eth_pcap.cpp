@@ -0,0 +1,124 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+struct pcapng_block {
+    u32 type;
+    vector<u8> body;
+};
+
+template <typename T>
+static T get(const vector<u8>& buf, size_t off) {
+    T val = T();
+    EXPECT_LE(off + sizeof(T), buf.size());
+    if (off + sizeof(T) <= buf.size())
+        memcpy(&val, buf.data() + off, sizeof(T));
+    return val;
+}
+
+static vector<pcapng_block> read_blocks(const string& file) {
+    ifstream is(file, std::ios::binary);
+    EXPECT_TRUE(is.good()) << "cannot open " << file;
+    vector<u8> data((std::istreambuf_iterator<char>(is)),
+                    std::istreambuf_iterator<char>());
+
+    vector<pcapng_block> blocks;
+    size_t off = 0;
+    while (off + 12 <= data.size()) {
+        u32 type = get<u32>(data, off);
+        u32 len = get<u32>(data, off + 4);
+        EXPECT_EQ(len % 4, 0) << "block at " << off;
+        EXPECT_GE(len, 12) << "block at " << off;
+        if (len < 12 || off + len > data.size())
+            break;
+
+        // the total length is repeated at the end of every block
+        EXPECT_EQ(get<u32>(data, off + len - 4), len) << "block at " << off;
+
+        auto begin = data.begin() + off + 8;
+        blocks.push_back({ type, vector<u8>(begin, begin + len - 12) });
+        off += len;
+    }
+
+    EXPECT_EQ(off, data.size());
+    return blocks;
+}
+
+// returns the value of the given option or an empty vector
+static vector<u8> find_option(const vector<u8>& body, size_t off, u16 code) {
+    while (off + 4 <= body.size()) {
+        u16 opt = get<u16>(body, off);
+        u16 len = get<u16>(body, off + 2);
+        if (opt == 0 || off + 4 + len > body.size())
+            break;
+
+        auto begin = body.begin() + off + 4;
+        if (opt == code)
+            return vector<u8>(begin, begin + len);
+        off += 4 + ((len + 3) & ~3);
+    }
+
+    return vector<u8>();
+}
+
+TEST(ethernet, pcap) {
+    ethernet::bridge bridge("bridge");
+
+    // everything after the prefix names the file, including colons
+    const string file = "eth:pcap.pcapng";
+    auto* pcap = ethernet::backend::create(&bridge, "pcap:" + file);
+    ASSERT_NE(pcap, nullptr);
+    EXPECT_STREQ(pcap->type(), ("pcap:" + file).c_str());
+
+    vector<u8> payload = { 0x11, 0x22, 0x33 };
+    eth_frame tx("ff:ff:ff:ff:ff:ff", "12:23:34:45:56:67", payload);
+    eth_frame rx("12:23:34:45:56:67", "ff:ff:ff:ff:ff:ff", payload);
+    pcap->send_to_host(tx);
+    pcap->observe_to_guest(rx);
+    delete pcap;
+
+    vector<pcapng_block> blocks = read_blocks(file);
+    ASSERT_EQ(blocks.size(), 4);
+
+    const pcapng_block& shb = blocks[0];
+    EXPECT_EQ(shb.type, 0x0a0d0d0a);
+    EXPECT_EQ(get<u32>(shb.body, 0), 0x1a2b3c4d);
+    EXPECT_EQ(get<u16>(shb.body, 4), 1);
+    EXPECT_EQ(get<u16>(shb.body, 6), 0);
+
+    const pcapng_block& idb = blocks[1];
+    EXPECT_EQ(idb.type, 1);
+    EXPECT_EQ(get<u16>(idb.body, 0), 1); // ethernet
+    EXPECT_EQ(find_option(idb.body, 8, 9), vector<u8>({ 9 })); // ns
+    vector<u8> name = find_option(idb.body, 8, 2);
+    EXPECT_EQ(string(name.begin(), name.end()), "bridge");
+
+    const eth_frame* frames[] = { &tx, &rx };
+    const u32 flags[] = { 2, 1 }; // outbound, inbound
+    for (size_t i = 0; i < 2; i++) {
+        const pcapng_block& epb = blocks[2 + i];
+        const eth_frame& frame = *frames[i];
+        EXPECT_EQ(epb.type, 6);
+        EXPECT_EQ(get<u32>(epb.body, 0), 0); // interface id
+        EXPECT_EQ(get<u32>(epb.body, 12), frame.size());
+        EXPECT_EQ(get<u32>(epb.body, 16), frame.size());
+
+        auto data = epb.body.begin() + 20;
+        EXPECT_TRUE(std::equal(frame.begin(), frame.end(), data));
+
+        size_t opts = 20 + ((frame.size() + 3) & ~3);
+        vector<u8> value = find_option(epb.body, opts, 2);
+        ASSERT_EQ(value.size(), sizeof(u32));
+        EXPECT_EQ(get<u32>(value, 0), flags[i]);
+    }
+
+    std::remove(file.c_str());
+}
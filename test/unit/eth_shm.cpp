@@ -0,0 +1,149 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include <unistd.h>
+
+#include "testing.h"
+
+static eth_frame make_frame(u16 seq) {
+    vector<u8> payload = { (u8)seq, (u8)(seq >> 8) };
+    return eth_frame("ff:ff:ff:ff:ff:ff", "12:23:34:45:56:67", payload);
+}
+
+static u16 frame_seq(const eth_frame& frame) {
+    size_t off = eth_frame::FRAME_HEADER_SIZE;
+    return frame[off] | (u16)frame[off + 1] << 8;
+}
+
+// Connects two bridges of the same simulation through "shm:<name>", the
+// first one becomes the server and the second one connects to it.
+class shm_test : public test_base, public eth_host
+{
+public:
+    ethernet::bridge a;
+    ethernet::bridge b;
+
+    eth_initiator_socket eth_tx_a;
+    eth_initiator_socket eth_tx_b;
+    eth_target_socket eth_rx_a;
+    eth_target_socket eth_rx_b;
+
+    vector<u16> received_a;
+    vector<u16> received_b;
+    vector<sc_time> arrival_b;
+
+    string type;
+
+    shm_test(const sc_module_name& nm):
+        test_base(nm),
+        eth_host(),
+        a("a"),
+        b("b"),
+        eth_tx_a("eth_tx_a"),
+        eth_tx_b("eth_tx_b"),
+        eth_rx_a("eth_rx_a"),
+        eth_rx_b("eth_rx_b"),
+        received_a(),
+        received_b(),
+        arrival_b(),
+        type(mkstr("shm:test-%d", (int)getpid())) {
+        eth_tx_a.bind(a.eth_rx);
+        eth_tx_b.bind(b.eth_rx);
+        a.eth_tx.bind(eth_rx_a);
+        b.eth_tx.bind(eth_rx_b);
+    }
+
+    virtual void eth_receive(const eth_target_socket& socket,
+                             const eth_frame& frame) override {
+        if (&socket == &eth_rx_a)
+            received_a.push_back(frame_seq(frame));
+        if (&socket == &eth_rx_b) {
+            received_b.push_back(frame_seq(frame));
+            arrival_b.push_back(sc_time_stamp());
+        }
+    }
+
+    // frames sent before both sides are connected get dropped, so keep
+    // sending until one of them makes it through
+    bool ping(ethernet::bridge& from, const vector<u16>& rx, u16 seq) {
+        for (size_t i = 0; i < 1000; i++) {
+            from.send_to_host(make_frame(seq));
+            mwr::usleep(100);
+            wait(1, SC_US);
+            if (stl_contains(rx, seq))
+                return true;
+        }
+
+        return false;
+    }
+
+    void test_timed() {
+        string timed = mkstr("shm:test-%d-timed:timed", (int)getpid());
+        size_t server = a.create_backend(timed);
+        size_t client = b.create_backend(timed);
+
+        // every attempt uses its own sequence number, so that we know when
+        // the frame that arrived was sent
+        received_b.clear();
+        arrival_b.clear();
+        vector<sc_time> sent;
+        for (u16 seq = 0; seq < 1000 && received_b.empty(); seq++) {
+            sent.push_back(sc_time_stamp());
+            a.send_to_host(make_frame(seq));
+            mwr::usleep(100);
+            wait(1, SC_US);
+        }
+
+        ASSERT_FALSE(received_b.empty());
+
+        // frames must not reach the guest before the time they were sent
+        // at, those that arrive after it count as late
+        u64 late = 0;
+        for (size_t i = 0; i < received_b.size(); i++) {
+            ASSERT_LT(received_b[i], sent.size());
+            const sc_time& t = sent[received_b[i]];
+            EXPECT_GE(arrival_b[i], t) << "frame " << received_b[i];
+            if (arrival_b[i] > t)
+                late++;
+        }
+
+        EXPECT_EQ(b.late_frames(), late);
+
+        EXPECT_TRUE(b.destroy_backend(client));
+        EXPECT_TRUE(a.destroy_backend(server));
+    }
+
+    virtual void run_test() override {
+        size_t server = a.create_backend(type);
+        size_t client = b.create_backend(type);
+
+        EXPECT_TRUE(ping(a, received_b, 1));
+        EXPECT_TRUE(ping(b, received_a, 2));
+        EXPECT_FALSE(stl_contains(received_a, 1));
+        EXPECT_FALSE(stl_contains(received_b, 2));
+
+        // the server must notice the hangup and accept the next client
+        EXPECT_TRUE(b.destroy_backend(client));
+        client = b.create_backend(type);
+
+        EXPECT_TRUE(ping(a, received_b, 3));
+        EXPECT_TRUE(ping(b, received_a, 4));
+
+        EXPECT_TRUE(b.destroy_backend(client));
+        EXPECT_TRUE(a.destroy_backend(server));
+
+        test_timed();
+    }
+};
+
+TEST(ethernet, shm) {
+    shm_test test("test");
+    sc_core::sc_start();
+}
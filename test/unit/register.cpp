@@ -753,3 +753,59 @@ TEST(registers, minmaxsize) {
     EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 0);
     EXPECT_EQ(mock.test_reg, 0xaabbccdd);
 }
+
+class mock_peripheral_sparse : public peripheral
+{
+public:
+    vector<unique_ptr<reg<u32>>> regs;
+
+    mock_peripheral_sparse(const sc_module_name& nm):
+        peripheral(nm, ENDIAN_LITTLE), regs() {
+        for (u32 i = 0; i < 32; i++) {
+            string name = mkstr("reg%u", i);
+            regs.emplace_back(new reg<u32>(name, i * 8, 0x11111111 * i));
+            regs.back()->allow_read_write();
+        }
+
+        clk.stub(100 * MHz);
+        rst.stub();
+    }
+};
+
+TEST(registers, sparse_decode) {
+    mock_peripheral_sparse mock("sparse");
+    tlm_generic_payload tx;
+
+    u32 data = 0xabcdef01;
+    tx_setup(tx, TLM_WRITE_COMMAND, 0x50, &data, sizeof(data));
+    EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 4);
+    EXPECT_EQ(*mock.regs[10], 0xabcdef01);
+    EXPECT_EQ(*mock.regs[9], 0x99999999);
+    EXPECT_EQ(*mock.regs[11], 0xbbbbbbbb);
+
+    u8 buffer[8] = { 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc };
+    tx_setup(tx, TLM_READ_COMMAND, 0x0e, buffer, sizeof(buffer));
+    EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 4);
+    EXPECT_TRUE(success(tx));
+    EXPECT_EQ(buffer[1], 0xcc);
+    EXPECT_EQ(buffer[2], 0x22);
+    EXPECT_EQ(buffer[5], 0x22);
+    EXPECT_EQ(buffer[6], 0xcc);
+
+    memset(buffer, 0xcc, sizeof(buffer));
+    tx_setup(tx, TLM_READ_COMMAND, 0x36, buffer, 4);
+    EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 2);
+    EXPECT_EQ(buffer[1], 0xcc);
+    EXPECT_EQ(buffer[2], 0x77);
+    EXPECT_EQ(buffer[3], 0x77);
+
+    tx_setup(tx, TLM_READ_COMMAND, 0x7c, buffer, 4);
+    EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 0);
+    EXPECT_EQ(tx.get_response_status(), TLM_ADDRESS_ERROR_RESPONSE);
+
+    tx_setup(tx, TLM_READ_COMMAND, 0xf8, buffer, 8);
+    EXPECT_EQ(mock.transport(tx, SBI_NONE, VCML_AS_DEFAULT), 4);
+    EXPECT_EQ(buffer[0], 0x0f);
+    EXPECT_EQ(buffer[3], 0x11);
+    EXPECT_EQ(buffer[4], 0xcc);
+}
@@ -0,0 +1,131 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class regbank : public peripheral
+{
+public:
+    enum : size_t { NUM_REGS = 256 };
+
+    vector<unique_ptr<reg<u32>>> regs;
+    tlm_target_socket in;
+
+    regbank(const sc_module_name& nm): peripheral(nm), regs(), in("in") {
+        for (size_t i = 0; i < NUM_REGS; i++) {
+            string name = mkstr("reg%zu", i);
+            regs.emplace_back(new reg<u32>(name, i * 4, (u32)i));
+            regs.back()->allow_read_write();
+        }
+    }
+
+    virtual ~regbank() = default;
+};
+
+class tlm_host_harness : public test_base
+{
+public:
+    regbank bank;
+    tlm_initiator_socket out;
+
+    sc_event ev;
+    bool other_done;
+
+    tlm_host_harness(const sc_module_name& nm):
+        test_base(nm), bank("bank"), out("out"), ev("ev"), other_done() {
+        out.bind(bank.in);
+        clk_bind(*this, "clk", bank, "clk");
+        gpio_bind(*this, "rst", bank, "rst");
+        SC_HAS_PROCESS(tlm_host_harness);
+        SC_THREAD(other);
+    }
+
+    void other() {
+        wait(ev);
+        EXPECT_EQ(local_time(), SC_ZERO_TIME);
+        local_time() = sc_time(3, SC_NS);
+        EXPECT_EQ(local_time(), sc_time(3, SC_NS));
+        other_done = true;
+    }
+
+    void test_pool() {
+        tlm_pool& pool = tx_pool();
+        size_t hits = tx_pool_hits();
+        size_t misses = tx_pool_misses();
+        ASSERT_EQ(pool.size(), 0);
+
+        tlm_generic_payload* ptr = nullptr;
+        {
+            tlm_pooled_tx tx(pool);
+            ptr = tx.get();
+            EXPECT_TRUE(tx_has_sbi(*tx));
+            EXPECT_EQ(tx->get_ref_count(), 1);
+            tx_setup(*tx, TLM_WRITE_COMMAND, 0x40, nullptr, 4);
+            tx_set_cpuid(*tx, 3);
+            EXPECT_EQ(pool.size(), 0);
+        }
+
+        EXPECT_EQ(pool.size(), 1);
+        EXPECT_EQ(tx_pool_misses(), misses + 1);
+
+        {
+            tlm_pooled_tx tx(pool);
+            EXPECT_EQ(tx.get(), ptr);
+            EXPECT_EQ(tx->get_command(), TLM_IGNORE_COMMAND);
+            EXPECT_EQ(tx->get_address(), 0);
+            EXPECT_EQ(tx_cpuid(*tx), 0);
+
+            tlm_pooled_tx tx2(pool);
+            EXPECT_NE(tx2.get(), ptr);
+        }
+
+        EXPECT_EQ(pool.size(), 2);
+        EXPECT_EQ(tx_pool_hits(), hits + 1);
+        EXPECT_EQ(tx_pool_misses(), misses + 2);
+
+        // other threads cannot see the simulation thread's free list, but
+        // what they release ends up in the shared one and gets reused
+        std::thread worker([&]() -> void { tlm_pooled_tx tx(pool); });
+        worker.join();
+        EXPECT_EQ(pool.size(), 3);
+        EXPECT_EQ(tx_pool_misses(), misses + 3);
+
+        {
+            tlm_pooled_tx tx1(pool);
+            tlm_pooled_tx tx2(pool);
+            tlm_pooled_tx tx3(pool);
+            EXPECT_EQ(pool.size(), 0);
+        }
+
+        EXPECT_EQ(pool.size(), 3);
+        EXPECT_EQ(tx_pool_hits(), hits + 4);
+        EXPECT_EQ(tx_pool_misses(), misses + 3);
+    }
+
+    virtual void run_test() override {
+        local_time() = sc_time(5, SC_NS);
+        EXPECT_EQ(local_time(), sc_time(5, SC_NS));
+        EXPECT_FALSE(in_transaction());
+        EXPECT_EQ(current_cpu(), -1);
+
+        ev.notify();
+        sync();
+        wait(SC_ZERO_TIME);
+        EXPECT_TRUE(other_done);
+        EXPECT_EQ(local_time(), SC_ZERO_TIME);
+
+        test_pool();
+    }
+};
+
+TEST(tlm_host, process_data) {
+    tlm_host_harness test("test");
+    sc_core::sc_start();
+}
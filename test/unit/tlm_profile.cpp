@@ -0,0 +1,91 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+class tlm_profile_harness : public test_base
+{
+public:
+    u8 mem[0x2000];
+
+    tlm_initiator_socket out;
+    tlm_target_socket in;
+
+    tlm_profile_harness(const sc_module_name& nm):
+        test_base(nm), mem(), out("out"), in("in") {
+        out.bind(in);
+        out.profile = true;
+        in.profile = true;
+        map_dmi(mem, 0, 0xfff, VCML_ACCESS_READ_WRITE);
+    }
+
+    virtual ~tlm_profile_harness() = default;
+
+    virtual unsigned int transport(tlm_target_socket& socket,
+                                   tlm_generic_payload& tx,
+                                   const tlm_sbi& sideband) override {
+        u64 addr = tx.get_address();
+        unsigned int size = tx.get_data_length();
+        if (tx.is_read())
+            memcpy(tx.get_data_ptr(), mem + addr, size);
+        if (tx.is_write())
+            memcpy(mem + addr, tx.get_data_ptr(), size);
+        tx.set_response_status(TLM_OK_RESPONSE);
+        return size;
+    }
+
+    virtual void run_test() override {
+        u32 data = 0;
+        for (int i = 0; i < 4; i++)
+            EXPECT_OK(out.writew(0x1000 + i * 4, data, SBI_NODMI));
+        EXPECT_OK(out.writew(0x10, data, SBI_NODMI));
+        EXPECT_OK(out.readw(0x1000, data, SBI_DEBUG));
+
+        ASSERT_TRUE(out.lookup_dmi_ptr(0, 4));
+        for (int i = 0; i < 8; i++)
+            EXPECT_OK(out.readw(0x20, data));
+
+        auto targets = in.get_profile().collect();
+        ASSERT_EQ(targets.size(), 2);
+        tlm_profile_counters total = in.get_profile().total();
+        EXPECT_EQ(total.count, 6);
+        EXPECT_EQ(total.bytes, 24);
+        EXPECT_EQ(total.debug, 1);
+        EXPECT_EQ(total.dmi, 1); // write to DMI-capable 0x10
+        EXPECT_EQ(total.errors, 0);
+
+        auto initiators = out.get_profile().collect();
+        ASSERT_EQ(initiators.size(), 2);
+        total = out.get_profile().total();
+        EXPECT_EQ(total.count, 14);
+        EXPECT_EQ(total.dmi, 8);
+
+        for (const auto& entry : initiators) {
+            if (entry.addr.start == 0x1000) {
+                EXPECT_EQ(entry.addr.end, 0x1fff);
+                EXPECT_EQ(entry.counters.count, 5);
+                EXPECT_EQ(entry.counters.dmi, 0);
+            }
+        }
+
+        EXPECT_TRUE(execute("profile", std::cout));
+        std::cout << std::endl;
+
+        EXPECT_TRUE(execute("profile", { "reset" }, std::cout));
+        std::cout << std::endl;
+        EXPECT_TRUE(out.get_profile().collect().empty());
+        EXPECT_TRUE(in.get_profile().collect().empty());
+    }
+};
+
+TEST(tlm, profile) {
+    tlm_profile_harness test("profile");
+    sc_core::sc_start();
+}
@@ -0,0 +1,180 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+MATCHER_P3(match_batch, dir, addr, size, "matches batch trace entry") {
+    return arg.kind == PROTO_TLM && arg.dir == dir &&
+           arg.payload.get_address() == addr &&
+           arg.payload.get_data_length() == size;
+}
+
+class mock_tracer : public vcml::tracer
+{
+public:
+    mock_tracer(): tracer() {}
+    MOCK_METHOD(void, trace, (const tracer::activity<tlm_generic_payload>&),
+                (override));
+
+    virtual void trace(const activity<gpio_payload>&) override {}
+    virtual void trace(const activity<clk_payload>&) override {}
+    virtual void trace(const activity<pci_payload>&) override {}
+    virtual void trace(const activity<i2c_payload>&) override {}
+    virtual void trace(const activity<spi_payload>&) override {}
+    virtual void trace(const activity<sd_command>&) override {}
+    virtual void trace(const activity<sd_data>&) override {}
+    virtual void trace(const activity<vq_message>&) override {}
+    virtual void trace(const activity<serial_payload>&) override {}
+    virtual void trace(const activity<eth_frame>&) override {}
+    virtual void trace(const activity<can_frame>&) override {}
+    virtual void trace(const activity<usb_packet>&) override {}
+};
+
+class tlm_vectored_harness : public test_base
+{
+public:
+    u8 mem[256];
+
+    mock_tracer tracer;
+
+    tlm_initiator_socket out;
+    tlm_target_socket in;
+
+    tlm_vectored_harness(const sc_module_name& nm):
+        test_base(nm), mem(), tracer(), out("out"), in("in") {
+        out.bind(in);
+        map_dmi(mem, 0, 127, VCML_ACCESS_READ_WRITE);
+    }
+
+    virtual ~tlm_vectored_harness() = default;
+
+    MOCK_METHOD(void, receive, (u64, unsigned int));
+
+    virtual unsigned int transport(tlm_target_socket& socket,
+                                   tlm_generic_payload& tx,
+                                   const tlm_sbi& sideband) override {
+        EXPECT_TRUE(thctl_is_sysc_thread());
+        u64 addr = tx.get_address();
+        unsigned int size = tx.get_data_length();
+        receive(addr, size);
+        if (tx.is_read())
+            memcpy(tx.get_data_ptr(), mem + addr, size);
+        if (tx.is_write())
+            memcpy(mem + addr, tx.get_data_ptr(), size);
+        tx.set_response_status(TLM_OK_RESPONSE);
+        return size;
+    }
+
+    void test_access() {
+        u8 a[16], b[16], c[16], d[4];
+        memset(a, 0xaa, sizeof(a));
+        memset(b, 0xbb, sizeof(b));
+        memset(c, 0xcc, sizeof(c));
+        memset(d, 0xdd, sizeof(d));
+
+        vector<tlm_iovec> iov = {
+            { 0x10, a, sizeof(a) },
+            { 0x20, b, sizeof(b) },
+            { 0x78, c, sizeof(c) }, // crosses end of DMI region
+            { 0x90, d, sizeof(d) },
+        };
+
+        unsigned int nbytes = 0;
+        EXPECT_CALL(*this, receive(0x80, 8));
+        EXPECT_CALL(*this, receive(0x90, 4));
+        EXPECT_OK(out.access_vectored(TLM_WRITE_COMMAND, iov, SBI_NONE,
+                                      &nbytes));
+        EXPECT_EQ(nbytes, 52);
+        EXPECT_EQ(mem[0x0f], 0x00);
+        EXPECT_EQ(mem[0x10], 0xaa);
+        EXPECT_EQ(mem[0x2f], 0xbb);
+        EXPECT_EQ(mem[0x30], 0x00);
+        EXPECT_EQ(mem[0x78], 0xcc);
+        EXPECT_EQ(mem[0x87], 0xcc);
+        EXPECT_EQ(mem[0x88], 0x00);
+        EXPECT_EQ(mem[0x93], 0xdd);
+
+        memset(a, 0, sizeof(a));
+        memset(c, 0, sizeof(c));
+        iov = { { 0x10, a, sizeof(a) }, { 0x78, c, sizeof(c) } };
+        EXPECT_CALL(*this, receive(0x80, 8));
+        EXPECT_OK(out.access_vectored(TLM_READ_COMMAND, iov, SBI_NONE,
+                                      &nbytes));
+        EXPECT_EQ(nbytes, 32);
+        EXPECT_EQ(a[15], 0xaa);
+        EXPECT_EQ(c[0], 0xcc);
+        EXPECT_EQ(c[15], 0xcc);
+    }
+
+    void test_tracing() {
+        u8 a[16] = {}, b[8] = {}, c[8] = {};
+        vector<tlm_iovec> iov = {
+            { 0x10, a, sizeof(a) },
+            { 0x20, c, sizeof(c) },
+            { 0x90, b, sizeof(b) },
+        };
+
+        // one record pair per contiguous run, none for the single pieces
+        out.trace_all = true;
+        EXPECT_CALL(*this, receive(0x90, 8));
+        EXPECT_CALL(tracer, trace(match_batch(TRACE_FW, 0x10, 24))).Times(1);
+        EXPECT_CALL(tracer, trace(match_batch(TRACE_BW, 0x10, 24))).Times(1);
+        EXPECT_CALL(tracer, trace(match_batch(TRACE_FW, 0x90, 8))).Times(1);
+        EXPECT_CALL(tracer, trace(match_batch(TRACE_BW, 0x90, 8))).Times(1);
+        EXPECT_OK(out.access_vectored(TLM_READ_COMMAND, iov));
+        out.trace_all = false;
+
+        EXPECT_CALL(*this, receive(0x90, 8));
+        EXPECT_CALL(tracer, trace(_)).Times(0);
+        EXPECT_OK(out.access_vectored(TLM_WRITE_COMMAND, iov));
+    }
+
+    void test_async() {
+        u8 a[16], b[8];
+        memset(a, 0x5a, sizeof(a));
+        memset(b, 0xa5, sizeof(b));
+
+        vector<tlm_iovec> iov = {
+            { 0x40, a, sizeof(a) },
+            { 0x98, b, sizeof(b) },
+        };
+
+        // the DMI piece is done on the worker, the other one is funneled
+        // through the SystemC thread instead of raising an error
+        unsigned int nbytes = 0;
+        tlm_response_status rs = TLM_INCOMPLETE_RESPONSE;
+        EXPECT_CALL(*this, receive(0x98, 8));
+        sc_async([&]() -> void {
+            EXPECT_FALSE(thctl_is_sysc_thread());
+            rs = out.access_vectored(TLM_WRITE_COMMAND, iov, SBI_NONE,
+                                     &nbytes);
+        });
+
+        sc_join_async();
+        EXPECT_OK(rs);
+        EXPECT_EQ(nbytes, 24);
+        EXPECT_EQ(mem[0x40], 0x5a);
+        EXPECT_EQ(mem[0x4f], 0x5a);
+        EXPECT_EQ(mem[0x98], 0xa5);
+        EXPECT_EQ(mem[0x9f], 0xa5);
+    }
+
+    virtual void run_test() override {
+        ASSERT_TRUE(out.lookup_dmi_ptr(0, 128, VCML_ACCESS_READ_WRITE));
+        test_access();
+        test_tracing();
+        test_async();
+    }
+};
+
+TEST(tlm, access_vectored) {
+    tlm_vectored_harness test("vectored");
+    sc_core::sc_start();
+}
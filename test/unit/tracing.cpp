@@ -8,6 +8,8 @@
  *                                                                            *
  ******************************************************************************/
 
+#include <unistd.h>
+
 #include "testing.h"
 
 MATCHER_P3(match_trace, dir, addr, data, "matches trace entry") {
@@ -47,6 +49,8 @@ class test_harness : public test_base
 public:
     tracer_term term;
     mock_tracer mock;
+    tracer_file text;
+    tracer_binary binary;
 
     u64 addr;
     u32 data;
@@ -55,7 +59,15 @@ public:
     tlm_target_socket in;
 
     test_harness(const sc_module_name& nm):
-        test_base(nm), term(), mock(), addr(), data(), out("out"), in("in") {
+        test_base(nm),
+        term(),
+        mock(),
+        text("trace.txt"),
+        binary("trace.bin"),
+        addr(),
+        data(),
+        out("out"),
+        in("in") {
         out.bind(in);
     }
 
@@ -99,9 +111,140 @@ public:
 
         EXPECT_CALL(mock, trace(match_trace_error(true))).Times(1);
         EXPECT_AE(out.writew(0, data)) << "did not get an address error";
+
+        test_binary();
+    }
+
+    void test_binary() {
+        // these protocols use fixed-layout records instead of text
+        gpio_payload gpio = { 3, true };
+        clk_payload clk = { 0, 100 * MHz };
+        serial_payload serial = { 'A', 0xff, 115200, SERIAL_8_BITS,
+                                  SERIAL_PARITY_NONE, SERIAL_STOP_1 };
+        can_frame can{};
+        can.msgid = 0x123;
+        can.dlc = 2;
+        can.data[0] = 0x11;
+        can.data[1] = 0x22;
+
+        tracer::record(TRACE_FW, out, gpio);
+        tracer::record(TRACE_FW, out, clk);
+        tracer::record(TRACE_FW, out, serial);
+        tracer::record(TRACE_FW, out, can);
+
+        binary.flush();
+        EXPECT_EQ(binary.records(), 7);
+        EXPECT_EQ(binary.dropped(), 0);
+
+        stringstream converted;
+        tracer_binary::convert("trace.bin", converted);
+
+        ifstream file("trace.txt");
+        stringstream expected;
+        expected << file.rdbuf();
+
+        EXPECT_FALSE(expected.str().empty());
+        EXPECT_EQ(converted.str(), expected.str());
     }
 };
 
+class test_port : public sc_object
+{
+public:
+    test_port(const char* nm): sc_object(nm) {}
+};
+
+static void trace_gpio(tracer_binary& tr, const sc_object& port, size_t n) {
+    gpio_payload gpio = { GPIO_NO_VECTOR, false };
+    for (size_t i = 0; i < n; i++) {
+        gpio.state = i & 1;
+        sc_time t(i, SC_NS);
+        const tracer::activity<gpio_payload> msg = {
+            PROTO_GPIO, TRACE_FW, false, port, gpio, t, i,
+        };
+
+        tr.trace(msg);
+    }
+}
+
+TEST(tracing, binary_bounded) {
+    test_port port("bounded");
+    tracer_binary binary("bounded.bin");
+
+    // several times what fits into a ring: the producer has to wait for
+    // the writer thread instead of growing its ring or dropping records
+    const size_t n = 2 * tracer_binary::RING_SIZE / sizeof(gpio_payload);
+    trace_gpio(binary, port, n);
+    binary.flush();
+    EXPECT_EQ(binary.records(), n);
+    EXPECT_EQ(binary.dropped(), 0);
+    EXPECT_GT(binary.bytes_written(), 0);
+
+    std::remove("bounded.bin");
+}
+
+TEST(tracing, binary_write_error) {
+    if (access("/dev/full", W_OK) != 0)
+        GTEST_SKIP() << "/dev/full not available";
+
+    // writes fail once the stream buffer gets flushed, which must neither
+    // throw nor terminate the writer thread
+    test_port port("full");
+    tracer_binary binary("/dev/full");
+    trace_gpio(binary, port, 1000);
+    EXPECT_NO_THROW(binary.flush());
+    EXPECT_EQ(binary.records(), 0);
+    EXPECT_EQ(binary.dropped(), 1000);
+
+    trace_gpio(binary, port, 10);
+    EXPECT_EQ(binary.dropped(), 1010);
+}
+
+TEST(tracing, filter) {
+    u32 data = 0;
+    tlm_generic_payload rd, wr;
+    tx_setup(rd, TLM_READ_COMMAND, 0x1000, &data, sizeof(data));
+    tx_setup(wr, TLM_WRITE_COMMAND, 0x2000, &data, sizeof(data));
+    rd.set_response_status(TLM_OK_RESPONSE);
+    wr.set_response_status(TLM_ADDRESS_ERROR_RESPONSE);
+
+    trace_filter none("");
+    EXPECT_FALSE(none.is_active());
+    EXPECT_TRUE(none.accept(TRACE_FW, rd));
+
+    trace_filter proto("proto:gpio,clk");
+    EXPECT_TRUE(proto.is_active());
+    EXPECT_FALSE(proto.accept(TRACE_FW, rd));
+
+    trace_filter addr("proto:tlm addr:0x0..0xfff,0x1ffc..0x2003");
+    EXPECT_FALSE(addr.accept(TRACE_FW, rd));
+    EXPECT_TRUE(addr.accept(TRACE_FW, wr));
+
+    trace_filter cmd("cmd:rd");
+    EXPECT_TRUE(cmd.accept(TRACE_FW, rd));
+    EXPECT_FALSE(cmd.accept(TRACE_FW, wr));
+
+    trace_filter errors("errors");
+    EXPECT_FALSE(errors.accept(TRACE_FW, wr));
+    EXPECT_FALSE(errors.accept(TRACE_BW, rd));
+    EXPECT_TRUE(errors.accept(TRACE_BW, wr));
+
+    trace_filter window("time:10ns..20ns");
+    EXPECT_FALSE(window.accept(TRACE_FW, rd, sc_time(5, SC_NS)));
+    EXPECT_TRUE(window.accept(TRACE_FW, rd, sc_time(10, SC_NS)));
+    EXPECT_FALSE(window.accept(TRACE_FW, rd, sc_time(20, SC_NS)));
+
+    trace_filter sample("sample:3");
+    for (int i = 0; i < 6; i++) {
+        bool expect = (i % 3) == 0;
+        EXPECT_EQ(sample.accept(TRACE_FW, rd), expect) << "at " << i;
+        EXPECT_EQ(sample.accept(TRACE_BW, rd), expect) << "at " << i;
+    }
+
+    EXPECT_THROW(trace_filter("proto:foo"), report);
+    EXPECT_THROW(trace_filter("bogus"), report);
+}
+
 TEST(tracing, basic) {
     for (int i = 0; i < NUM_PROTOCOLS; i++) {
         EXPECT_STRNE(protocol_name((protocol_kind)i), "unknown protocol")
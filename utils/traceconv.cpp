@@ -0,0 +1,41 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2024 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This is work is licensed under the terms described in the LICENSE file     *
+ * found in the root directory of this source tree.                           *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vcml/tracing/tracer_binary.h"
+
+static void print_usage(const char* name) {
+    std::cerr << "Usage: " << name << " <input.bin> [output.txt]" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        if (argc == 3) {
+            std::ofstream os(argv[2]);
+            if (!os.is_open()) {
+                std::cerr << "cannot open " << argv[2] << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            vcml::tracer_binary::convert(argv[1], os);
+        } else {
+            vcml::tracer_binary::convert(argv[1], std::cout);
+        }
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}